@@ -0,0 +1,44 @@
+#ifndef FLARE_BENCH_ALLOC_COUNTER_H
+#define FLARE_BENCH_ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations made through operator new.
+// Replaces the global operator new/delete, so include it in exactly one translation unit (the benchmark's main file).
+
+namespace bench{
+
+inline std::atomic<size_t>& alloc_count(){
+	static std::atomic<size_t> n{0};
+	return n;
+}
+
+// average number of heap allocations per call of f() (after a warm-up call)
+template <class F>
+double allocs_per_call(F f, int n = 20){
+	f();
+	size_t before = alloc_count().load();
+	for (int i=0; i<n; ++i) f();
+	return double(alloc_count().load() - before)/n;
+}
+
+} // namespace bench
+
+void* operator new(size_t size){
+	bench::alloc_count().fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size){
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+#endif
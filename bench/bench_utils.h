@@ -0,0 +1,83 @@
+#ifndef FLARE_BENCH_BENCH_UTILS_H
+#define FLARE_BENCH_BENCH_UTILS_H
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace bench{
+
+// run f() n times after a warm-up call, and return the median time per call [ms]
+template <class F>
+double time_ms(F f, int n = 20){
+	f();
+	std::vector<double> times;
+	for (int i=0; i<n; ++i){
+		auto t1 = std::chrono::steady_clock::now();
+		f();
+		auto t2 = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::milli>(t2-t1).count());
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size()/2];
+}
+
+// latency distribution of a call [ms]
+struct Timings {
+	double p50 = 0, p90 = 0, p99 = 0, max = 0, mean = 0;
+};
+
+// run f() n times after a warm-up call, and return the latency percentiles
+template <class F>
+Timings time_stats(F f, int n = 100){
+	f();
+	std::vector<double> times;
+	for (int i=0; i<n; ++i){
+		auto t1 = std::chrono::steady_clock::now();
+		f();
+		auto t2 = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::milli>(t2-t1).count());
+	}
+	std::sort(times.begin(), times.end());
+	auto pct = [&](double p){ return times[std::min(times.size()-1, size_t(p*times.size()))]; };
+	Timings t;
+	t.p50 = pct(0.5);
+	t.p90 = pct(0.9);
+	t.p99 = pct(0.99);
+	t.max = times.back();
+	for (double x : times) t.mean += x/times.size();
+	return t;
+}
+
+inline void report(const std::string& name, double ms, double bytes = 0){
+	std::cout << "   " << std::left << std::setw(40) << name << std::right << std::setw(10) << std::fixed << std::setprecision(3) << ms << " ms";
+	if (bytes > 0) std::cout << std::setw(10) << std::setprecision(1) << bytes/1e6/(ms/1e3) << " MB/s";
+	std::cout << "\n";
+}
+
+// report latency percentiles, throughput (at the median) and heap allocations per call
+inline void report(const std::string& name, const Timings& t, double bytes = 0, double allocs = -1){
+	report(name, t.p50, bytes);
+	std::cout << "   " << std::setw(40) << "" << std::setprecision(3) << "   p90 = " << t.p90 << " ms, p99 = " << t.p99 << " ms, max = " << t.max << " ms";
+	if (allocs >= 0) std::cout << std::setprecision(1) << ", allocs/call = " << allocs;
+	std::cout << "\n";
+}
+
+// suppress std::cout output (e.g. library logging) while in scope
+struct Silence {
+	Silence(){ std::cout.setstate(std::ios::failbit); }
+	~Silence(){ std::cout.clear(); }
+};
+
+// prevent the compiler from optimizing away a result
+template <class T>
+inline void do_not_optimize(const T& x){
+	asm volatile("" : : "g"(&x) : "memory");
+}
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include "flare.h"
+#include "bench_utils.h"
+#include "synthetic_nc.h"
+
+// Throughput of reading different windows of one variable from N threads through a single cube
+// (const GeoCube::read), with unpacking on read. Without FLARE_NETCDF_THREADSAFE (and a thread safe
+// netCDF/HDF5 build) the netCDF calls are serialized, and only the work outside them scales.
+
+int main(){
+	bench::SyntheticSpec spec;
+	spec.nt = 64;
+	spec.chunks = {1, 90, 180};
+	std::string path = "bench/data_concurrent.nc";
+	bench::write_synthetic_nc(path, spec);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+	v.unpack_on_read = true;
+	v.scale_factor = 0.01;   // (exercise the unpacking pass)
+
+	// 16 windows of 90 x 180 points, one time step each
+	std::vector<flare::Hyperslab> slabs;
+	for (size_t i=0; i<16; ++i){
+		flare::Hyperslab h = v.hyperslab();
+		h = v.withIndices(h, v.lat_idx, 90*(i%4), 90);
+		h = v.withIndices(h, v.lon_idx, 180*(i/4), 180);
+		slabs.push_back(h);
+	}
+	double bytes_per_pass = 0;
+	for (auto& h : slabs) bytes_per_pass += h.size()*sizeof(float)*spec.nt;
+
+	std::cout << "Reading 16 windows x " << spec.nt << " time steps from one cube\n";
+	double t1 = 0;
+	for (size_t nthreads : {1, 2, 4, 8}){
+		auto pass = [&](){
+			std::vector<std::thread> threads;
+			for (size_t th=0; th<nthreads; ++th){
+				threads.emplace_back([&, th](){
+					std::vector<float> buf;
+					for (size_t i=th; i<slabs.size(); i+=nthreads){
+						for (size_t t=0; t<spec.nt; ++t){
+							v.read(v.withIndices(slabs[i], v.t_idx, t, 1), buf);
+							bench::do_not_optimize(buf);
+						}
+					}
+				});
+			}
+			for (auto& th : threads) th.join();
+		};
+		double ms = bench::time_ms(pass, 5);
+		if (nthreads == 1) t1 = ms;
+		bench::report(std::to_string(nthreads) + " threads", ms, bytes_per_pass);
+		std::cout << "      speedup = " << t1/ms << "x\n";
+	}
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <iostream>
+#include "flare.h"
+#include "bench_utils.h"
+#include "synthetic_nc.h"
+
+// Reading a compressed (deflate + shuffle) full-globe, multi-step block: serial decompression
+// through getVar vs. parallel chunk decompression (GeoCube::setDecompressionPool) with 1-8 threads.
+// Needs a build with HDF5=1; otherwise only the getVar baseline is reported.
+
+int main(){
+	bench::SyntheticSpec spec;
+	spec.nt = 48;
+	spec.deflate_level = 4;
+	spec.shuffle = true;
+	spec.chunks = {4, 90, 180};
+	std::string path = "bench/data_decompress.nc";
+	bench::write_synthetic_nc(path, spec);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+
+	double bytes = spec.nt*spec.nlat*spec.nlon*sizeof(float);
+	std::cout << "Reading " << spec.nt << " x " << spec.nlat << " x " << spec.nlon << " (deflate level " << spec.deflate_level << " + shuffle, chunks 4 x 90 x 180)\n";
+
+	std::vector<float> ref;
+	double t_getvar = bench::time_ms([&](){ v.readBlock(0, spec.nt); }, 5);
+	ref = v.vec;
+	bench::report("getVar", t_getvar, bytes);
+
+	for (size_t nthreads : {1, 2, 4, 8}){
+		flare::ThreadPool pool(nthreads);
+		if (!v.setDecompressionPool(&pool)){
+			std::cout << "   parallel decompression not available (build with HDF5=1)\n";
+			break;
+		}
+		double ms = bench::time_ms([&](){ v.readBlock(0, spec.nt); }, 5);
+		bench::report(std::to_string(nthreads) + " threads", ms, bytes);
+		std::cout << "      speedup vs getVar = " << t_getvar/ms << "x" << ((v.vec == ref)? "" : "   (DATA MISMATCH!)") << "\n";
+		v.setDecompressionPool(nullptr);
+	}
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include "flare.h"
+#include "bench_utils.h"
+#include "alloc_counter.h"
+#include "synthetic_nc.h"
+
+// Baseline timings of the I/O and time-math hot paths on synthetic files of different
+// sizes, chunkings and compressions: metadata reading, slice and block reads,
+// setCoordBounds, julian_to_index, and date <--> julian conversions.
+
+struct Config {
+	std::string name;
+	bench::SyntheticSpec spec;
+};
+
+void bench_file(const Config& cfg){
+	std::string path = "bench/data_io.nc";
+	bench::write_synthetic_nc(path, cfg.spec);
+	const auto& spec = cfg.spec;
+	double slice_bytes = spec.nlat*spec.nlon*sizeof(float);
+
+	std::cout << cfg.name << " (" << spec.nt << " x " << spec.nlat << " x " << spec.nlon << ")\n";
+
+	// metadata, without and with the metadata cache
+	for (bool cached : {false, true}){
+		flare::MetaCache::instance().enabled = cached;
+		flare::MetaCache::instance().clear();
+		auto t = bench::time_stats([&](){
+			flare::NcFilePP f;
+			f.open(path, netCDF::NcFile::read);
+			f.readMeta();
+		}, 50);
+		bench::report(std::string("NcFilePP open + readMeta") + (cached? " (cached)" : ""), t);
+	}
+	flare::MetaCache::instance().enabled = true;
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+
+	bench::Timings t_meta;
+	{
+		bench::Silence q;
+		t_meta = bench::time_stats([&](){ flare::GeoCube<float> c; c.readMeta(in_file); }, 50);
+	}
+	bench::report("GeoCube::readMeta", t_meta);
+
+	flare::GeoCube<float> v;
+	{ bench::Silence q; v.readMeta(in_file); }
+
+	// successive time slices
+	size_t t = 0;
+	auto read_slice = [&](){ v.readBlock(t, 1); t = (t+1) % spec.nt; };
+	bench::Timings t_slice;
+	double a_slice;
+	{
+		bench::Silence q;
+		t_slice = bench::time_stats(read_slice, 2*spec.nt);
+		a_slice = bench::allocs_per_call(read_slice);
+	}
+	bench::report("readBlock (1 slice)", t_slice, slice_bytes, a_slice);
+
+	// blocks of 16 time steps
+	size_t nb = std::min(spec.nt, size_t(16));
+	v.setIndices(v.t_idx, 0, nb);
+	auto read_block = [&](){ v.readBlock(0, nb); };
+	bench::Timings t_block;
+	{
+		bench::Silence q;
+		t_block = bench::time_stats(read_block, 20);
+	}
+	bench::report("readBlock (16 slices)", t_block, nb*slice_bytes);
+
+	// regional window
+	v.setCoordBounds(v.lat_idx, 10, 40);
+	v.setCoordBounds(v.lon_idx, 60, 100);
+	bench::Timings t_region;
+	{
+		bench::Silence q;
+		t_region = bench::time_stats(read_slice, 2*spec.nt);
+	}
+	bench::report("readBlock (1 slice, 30x40 deg window)", t_region, v.sliceSize()*sizeof(float));
+
+	// coordinate lookups
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> ulat(-80, 0), ulon(-170, 0);
+	auto t_bounds = bench::time_stats([&](){
+		float lat0 = ulat(rng), lon0 = ulon(rng);
+		v.setCoordBounds(v.lat_idx, lat0, lat0 + 40);
+		v.setCoordBounds(v.lon_idx, lon0, lon0 + 90);
+	}, 1000);
+	bench::report("setCoordBounds (lat + lon)", t_bounds);
+
+	double j0 = v.t_index_to_julian(0);
+	std::uniform_real_distribution<double> uj(j0, j0 + spec.nt);
+	std::vector<double> js(10000);
+	for (auto& j : js) j = uj(rng);
+	size_t sum = 0;
+	double ms = bench::time_ms([&](){ for (double j : js) sum += v.julian_to_index(j, true, true); });
+	bench::do_not_optimize(sum);
+	bench::report("julian_to_index (per 10^4 calls)", ms);
+
+	std::remove(path.c_str());
+}
+
+int main(){
+	std::vector<Config> configs;
+
+	Config c;
+	c.name = "small, contiguous";
+	c.spec.nt = 64; c.spec.nlat = 180; c.spec.nlon = 360;
+	configs.push_back(c);
+
+	c.name = "0.5 deg, contiguous";
+	c.spec.nlat = 360; c.spec.nlon = 720;
+	configs.push_back(c);
+
+	c.name = "0.5 deg, slice chunks, deflate 4 + shuffle";
+	c.spec.chunks = {1, 360, 720}; c.spec.deflate_level = 4; c.spec.shuffle = true;
+	configs.push_back(c);
+
+	c.name = "0.5 deg, time-series chunks, deflate 4";
+	c.spec.chunks = {64, 45, 90}; c.spec.shuffle = false;
+	configs.push_back(c);
+
+	for (auto& cfg : configs) bench_file(cfg);
+
+	// date <--> julian conversions
+	std::cout << "time math\n";
+	std::vector<double> js(100000);
+	for (size_t i=0; i<js.size(); ++i) js[i] = 2451545.0 + i*0.37;
+	std::vector<std::tm> dates(js.size());
+	double ms = bench::time_ms([&](){ for (size_t i=0; i<js.size(); ++i) dates[i] = flare::julian_to_date(js[i]); });
+	bench::report("julian_to_date (per 10^5 calls)", ms);
+	double sum = 0;
+	ms = bench::time_ms([&](){ for (auto& d : dates) sum += flare::date_to_julian(d); });
+	bench::do_not_optimize(sum);
+	bench::report("date_to_julian (per 10^5 calls)", ms);
+	double a = bench::allocs_per_call([&](){ sum += flare::datestring_to_julian("2001-03-04 05:06:07"); }, 1000);
+	ms = bench::time_ms([&](){ for (int i=0; i<10000; ++i) sum += flare::datestring_to_julian("2001-03-04 05:06:07"); });
+	bench::report("datestring_to_julian (per 10^4 calls)", ms);
+	std::cout << "   " << std::setw(40) << "" << "   allocs/call = " << a << "\n";
+
+	return 0;
+}
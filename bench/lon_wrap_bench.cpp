@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <iostream>
+#include "flare.h"
+#include "bench_utils.h"
+#include "synthetic_nc.h"
+
+// Reading a region that crosses the dateline (the Pacific, 150E - 130W): reading the full globe and cutting
+// the columns out, vs. a wrapped longitude range (setLonBounds), which reads only the two pieces of the region.
+
+int main(){
+	bench::SyntheticSpec spec;
+	spec.nt = 24;
+	spec.chunks = {1, 90, 180};
+	std::string path = "bench/data_lon_wrap.nc";
+	bench::write_synthetic_nc(path, spec);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+
+	flare::GeoCube<float> full, pacific;
+	full.readMeta(in_file);
+	pacific.readMeta(in_file);
+	full.setCoordBounds(full.lat_idx, -40, 40);
+	pacific.setCoordBounds(pacific.lat_idx, -40, 40);
+	pacific.setLonBounds(150, -130, 1);
+
+	size_t nlat = full.getCounts()[full.lat_idx], nlon = full.getCounts()[full.lon_idx];
+	size_t start = pacific.getStarts()[pacific.lon_idx], count = pacific.getCounts()[pacific.lon_idx];
+	double bytes = spec.nt*nlat*count*sizeof(float);
+	std::cout << "Region of " << nlat << " x " << count << " points (of " << nlon << " longitudes), " << spec.nt << " time steps\n";
+
+	std::vector<float> cut(nlat*count);
+	auto read_full = [&](){
+		for (size_t t=0; t<spec.nt; ++t){
+			full.readBlock(t, 1);
+			for (size_t r=0; r<nlat; ++r)
+				for (size_t i=0; i<count; ++i) cut[r*count + i] = full.vec[r*nlon + (start + i) % nlon];
+			bench::do_not_optimize(cut);
+		}
+	};
+	auto read_wrapped = [&](){
+		for (size_t t=0; t<spec.nt; ++t){
+			pacific.readBlock(t, 1);
+			bench::do_not_optimize(pacific.vec);
+		}
+	};
+	bench::report("full globe + cut", bench::time_ms(read_full, 10), bytes);
+	bench::report("wrapped range", bench::time_ms(read_wrapped, 10), bytes);
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include "flare.h"
+#include "bench_utils.h"
+#include "synthetic_nc.h"
+
+// Extract full time series at many sites: one tiny read per site (setIndices + readBlock)
+// vs. GeoCube::readPoints, which reads each chunk once.
+
+int main(){
+	bench::SyntheticSpec spec;
+	spec.nt = 365;
+	spec.deflate_level = 4;
+	spec.chunks = {73, 45, 90};
+	std::string path = "bench/data_points.nc";
+	bench::write_synthetic_nc(path, spec);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+
+	const size_t nsites = 2000;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> ulat(-60, 75), ulon(-180, 180);
+	std::vector<double> lats(nsites), lons(nsites);
+	for (size_t i=0; i<nsites; ++i){ lats[i] = ulat(rng); lons[i] = ulon(rng); }
+
+	std::vector<float> per_site(nsites*spec.nt);
+	auto loop = [&](){
+		for (size_t i=0; i<nsites; ++i){
+			v.setIndices(v.lat_idx, v.coord_to_index(v.lat_idx, lats[i]), 1);
+			v.setIndices(v.lon_idx, v.coord_to_index(v.lon_idx, lons[i]), 1);
+			v.readBlock(0, spec.nt);
+			std::copy(v.vec.begin(), v.vec.end(), per_site.begin() + i*spec.nt);
+		}
+	};
+
+	Tensor<float> pts;
+	auto batched = [&](){
+		pts = v.readPoints(lats, lons, 0, spec.nt, flare::Sampling::nearest);
+	};
+
+	auto batched_bilinear = [&](){
+		pts = v.readPoints(lats, lons, 0, spec.nt, flare::Sampling::bilinear);
+	};
+
+	std::cout << "Extracting " << nsites << " sites x " << spec.nt << " days\n";
+	double t_loop = bench::time_ms(loop, 3);
+	double t_batch = bench::time_ms(batched, 3);
+	double t_bilin = bench::time_ms(batched_bilinear, 3);
+	bench::report("per-site readBlock loop", t_loop);
+	bench::report("readPoints (nearest)", t_batch);
+	bench::report("readPoints (bilinear)", t_bilin);
+	std::cout << "   speedup (nearest) = " << t_loop/t_batch << "x\n";
+
+	batched();
+	if (pts.vec != per_site){
+		std::cout << "MISMATCH between per-site and batched extraction\n";
+		return 1;
+	}
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include "flare.h"
+#include "reader_group.h"
+#include "bench_utils.h"
+#include "synthetic_nc.h"
+
+// Wall-clock time per timestep for reading a set of forcing variables
+// one after another vs. concurrently through a ReaderGroup.
+
+int main(){
+	const int nvars = 8;
+	bench::SyntheticSpec spec;
+	spec.nt = 30;
+	spec.deflate_level = 4;
+	spec.chunks = {1, 180, 360};
+
+	std::vector<std::string> paths;
+	for (int i=0; i<nvars; ++i){
+		spec.varname = "var" + std::to_string(i);
+		paths.push_back("bench/data_var" + std::to_string(i) + ".nc");
+		bench::write_synthetic_nc(paths.back(), spec);
+	}
+
+	std::vector<std::unique_ptr<flare::NcFilePP>> files;
+	std::vector<std::unique_ptr<flare::GeoCube<float>>> cubes;
+	for (int i=0; i<nvars; ++i){
+		files.push_back(std::make_unique<flare::NcFilePP>());
+		files.back()->open(paths[i], netCDF::NcFile::read);
+		files.back()->readMeta();
+		cubes.push_back(std::make_unique<flare::GeoCube<float>>());
+		cubes.back()->readMeta(*files.back());
+	}
+
+	double t0 = flare::datestring_to_julian("2000-01-01 00:00:00");
+	double day = 0;
+
+	auto serial = [&](){
+		for (auto& c : cubes) c->readBlock(t0 + day, true, false);
+		day += 1;
+	};
+
+	flare::ReaderGroup<float> group;
+	for (auto& c : cubes) group.add(*c);
+	auto grouped = [&](){
+		group.readBlock(t0 + day, true, false);
+		day += 1;
+	};
+
+	double bytes = nvars*spec.nlat*spec.nlon*sizeof(float);
+	double t_serial = bench::time_ms(serial);
+	double t_group = bench::time_ms(grouped);
+
+	std::cout << "Reading " << nvars << " variables per timestep (" << group.nthreads() << " threads)\n";
+	bench::report("serial readBlock", t_serial, bytes);
+	bench::report("ReaderGroup::readBlock", t_group, bytes);
+	std::cout << "   speedup = " << t_serial/t_group << "x\n";
+
+	for (auto& p : paths) std::remove(p.c_str());
+	return 0;
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <cmath>
+#include "flare.h"
+#include "bench_utils.h"
+
+// Regridding throughput: weight generation (bilinear and conservative) and application
+// to one field (serial and on a thread pool), 0.5 deg --> 1 deg global grids
+
+int main(){
+	auto axis = [](double x0, double dx, size_t n){
+		std::vector<double> x(n);
+		for (size_t i=0; i<n; ++i) x[i] = x0 + i*dx;
+		return x;
+	};
+	std::vector<double> src_lats = axis(89.75, -0.5, 360), src_lons = axis(0.25, 0.5, 720);
+	std::vector<double> dst_lats = axis(-89.5, 1, 180), dst_lons = axis(-179.5, 1, 360);
+
+	std::vector<float> src(src_lats.size()*src_lons.size()), dst(dst_lats.size()*dst_lons.size());
+	for (size_t i=0; i<src.size(); ++i) src[i] = std::sin(0.001*i);
+
+	flare::ThreadPool pool;
+	std::cout << "Regridding " << src_lats.size() << "x" << src_lons.size() << " --> " << dst_lats.size() << "x" << dst_lons.size() << " (" << pool.size() << " threads)\n";
+
+	for (auto method : {flare::RegridMethod::bilinear, flare::RegridMethod::conservative}){
+		std::string name = (method == flare::RegridMethod::bilinear)? "bilinear" : "conservative";
+		flare::Regridder r;
+		double t_gen = bench::time_ms([&](){ r = flare::Regridder(src_lats, src_lons, dst_lats, dst_lons, method); }, 3);
+		double t_ser = bench::time_ms([&](){ r.apply(src.data(), dst.data(), -999.f); bench::do_not_optimize(dst); });
+		double t_par = bench::time_ms([&](){ r.apply(src.data(), dst.data(), -999.f, &pool); bench::do_not_optimize(dst); });
+
+		// bytes touched by the SpMV: weights + column indices + gathered source values + output
+		double bytes = r.weights.nnz()*(sizeof(double) + sizeof(uint32_t) + sizeof(float)) + dst.size()*sizeof(float);
+		std::cout << name << " (" << r.weights.nnz() << " weights)\n";
+		bench::report("weight generation", t_gen);
+		bench::report("apply (serial)", t_ser, bytes);
+		bench::report("apply (thread pool)", t_par, bytes);
+	}
+
+	return 0;
+}
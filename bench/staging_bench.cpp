@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <iostream>
+#include "flare.h"
+#include "bench_utils.h"
+#include "synthetic_nc.h"
+
+// Opening a small file and reading it piecewise (metadata + many small windows), from disk vs. staged
+// in memory (NcFilePP::Staging). On a local disk the file is in the page cache, so this mostly shows
+// the overhead of staging; the gain comes on file systems where each small read has a high latency.
+
+int main(){
+	bench::SyntheticSpec spec;
+	spec.nt = 12;
+	spec.nlat = 180;
+	spec.nlon = 360;
+	spec.deflate_level = 1;
+	spec.chunks = {1, 45, 90};
+	std::string path = "bench/data_staging.nc";
+	bench::write_synthetic_nc(path, spec);
+
+	using Staging = flare::NcFilePP::Staging;
+	std::cout << "Open + readMeta + 12 x 16 windows of 45 x 90 (" << flare::FileStamp::of(path).size/1024 << " kB file)\n";
+	for (auto [label, staging] : std::vector<std::pair<std::string, Staging>>{{"disk", Staging::none}, {"ram", Staging::ram}, {"mmap", Staging::mmap}}){
+		flare::MetaCache::instance().enabled = false;
+		auto pass = [&, staging = staging](){
+			flare::NcFilePP f;
+			f.open(path, netCDF::NcFile::read, staging);
+			f.readMeta();
+			flare::GeoCube<float> v;
+			{ bench::Silence q; v.readMeta(f); }
+			std::vector<float> buf;
+			for (size_t t=0; t<spec.nt; ++t){
+				for (size_t i=0; i<16; ++i){
+					flare::Hyperslab h = v.hyperslab();
+					h = v.withIndices(h, v.lat_idx, 45*(i%4), 45);
+					h = v.withIndices(h, v.lon_idx, 90*(i/4), 90);
+					h = v.withIndices(h, v.t_idx, t, 1);
+					v.read(h, buf);
+					bench::do_not_optimize(buf);
+				}
+			}
+		};
+		double ms = bench::time_ms(pass, 10);
+		bench::report(label, ms, spec.nt*spec.nlat*spec.nlon*sizeof(float));
+	}
+	flare::MetaCache::instance().enabled = true;
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <iostream>
+#include "flare.h"
+#include "bench_utils.h"
+#include "alloc_counter.h"
+#include "synthetic_nc.h"
+
+// Steady-state time stepping: after a warm-up step, reading successive slices with
+// readBlock (same shape every step) or into a caller-supplied buffer should not make
+// any heap allocations in flare.
+
+int main(){
+	bench::SyntheticSpec spec;
+	spec.nt = 365;
+	spec.nlat = 180;
+	spec.nlon = 360;
+	spec.chunks = {1, 180, 360};
+	spec.deflate_level = 1;
+	std::string path = "bench/data_steady.nc";
+	bench::write_synthetic_nc(path, spec);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+	v.setCoordBounds(v.lat_idx, -60, 60);
+
+	double j0 = v.t_index_to_julian(0);
+	double j = j0;
+	auto step_julian = [&](){ v.readBlock(j, true, true); j += 1; };
+
+	size_t t = 0;
+	auto step_index = [&](){ v.readBlock(t, 1); t = (t+1) % spec.nt; };
+
+	std::vector<float> buffer(v.sliceSize());
+	auto step_into = [&](){ v.readSliceInto(t, buffer.data()); t = (t+1) % spec.nt; };
+
+	double slice_bytes = v.sliceSize()*sizeof(float);
+	std::cout << "Time stepping over " << spec.nt << " daily slices (" << slice_bytes/1e3 << " kB each)\n";
+
+	bench::report("readBlock(julian_day)", bench::time_stats(step_julian, spec.nt), slice_bytes, bench::allocs_per_call(step_julian, spec.nt));
+	bench::report("readBlock(t, 1)", bench::time_stats(step_index, spec.nt), slice_bytes, bench::allocs_per_call(step_index, spec.nt));
+	bench::report("readSliceInto(caller buffer)", bench::time_stats(step_into, spec.nt), slice_bytes, bench::allocs_per_call(step_into, spec.nt));
+
+	std::remove(path.c_str());
+	return 0;
+}
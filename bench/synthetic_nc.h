@@ -0,0 +1,64 @@
+#ifndef FLARE_BENCH_SYNTHETIC_NC_H
+#define FLARE_BENCH_SYNTHETIC_NC_H
+
+#include <netcdf>
+#include <vector>
+#include <string>
+#include <cmath>
+
+namespace bench{
+
+struct SyntheticSpec {
+	std::string varname = "var";
+	size_t nt = 12, nlat = 360, nlon = 720;
+	int deflate_level = 0;                 // 0 = no compression
+	bool shuffle = false;
+	std::vector<size_t> chunks;            // (time, lat, lon) chunk shape, empty = library default
+};
+
+// Write a (time, lat, lon) float variable on a regular global grid with a daily time axis
+inline void write_synthetic_nc(const std::string& path, const SyntheticSpec& spec){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+
+	netCDF::NcDim tdim   = f.addDim("time");
+	netCDF::NcDim latdim = f.addDim("lat", spec.nlat);
+	netCDF::NcDim londim = f.addDim("lon", spec.nlon);
+
+	netCDF::NcVar tvar   = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	latvar.putAtt("units", "degrees_north");
+	lonvar.putAtt("units", "degrees_east");
+
+	netCDF::NcVar v = f.addVar(spec.varname, netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	v.putAtt("missing_value", netCDF::ncFloat, -999.f);
+	if (!spec.chunks.empty()){
+		std::vector<size_t> chunks = spec.chunks;
+		v.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+	}
+	if (spec.deflate_level > 0 || spec.shuffle) v.setCompression(spec.shuffle, spec.deflate_level > 0, spec.deflate_level);
+
+	std::vector<double> lats(spec.nlat), lons(spec.nlon);
+	for (size_t i=0; i<spec.nlat; ++i) lats[i] = -90 + (i+0.5)*180.0/spec.nlat;
+	for (size_t i=0; i<spec.nlon; ++i) lons[i] = -180 + (i+0.5)*360.0/spec.nlon;
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+
+	std::vector<float> slice(spec.nlat*spec.nlon);
+	for (size_t t=0; t<spec.nt; ++t){
+		double tval = t;
+		tvar.putVar(std::vector<size_t>{t}, std::vector<size_t>{1}, &tval);
+		for (size_t i=0; i<spec.nlat; ++i){
+			for (size_t j=0; j<spec.nlon; ++j){
+				slice[i*spec.nlon+j] = (std::fabs(lats[i]) > 80)? -999.f : float(std::sin(0.01*(t+i)) * std::cos(0.02*j) * 100);
+			}
+		}
+		v.putVar(std::vector<size_t>{t, 0, 0}, std::vector<size_t>{1, spec.nlat, spec.nlon}, slice.data());
+	}
+}
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <random>
+#include "../include/time_math.h"
+#include "bench_utils.h"
+
+// Batch date <--> julian kernels vs the scalar std::tm functions, and the fast ISO-8601
+// parser vs string_to_date (std::get_time)
+
+int main(){
+	const size_t n = 1000000;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> uj(2378497, 2524594);
+	std::vector<double> js(n), out(n);
+	for (auto& j : js) j = uj(rng);
+
+	std::cout << "Converting " << n << " timestamps\n";
+
+	std::vector<std::tm> tms(n);
+	double t_scalar = bench::time_ms([&](){ for (size_t i=0; i<n; ++i) tms[i] = flare::julian_to_date(js[i]); }, 5);
+	flare::DateColumns c;
+	c.resize(n);
+	double t_batch = bench::time_ms([&](){
+		flare::julian_to_ymdhms(js.data(), n, c.year.data(), c.month.data(), c.day.data(), c.hour.data(), c.minute.data(), c.second.data());
+		bench::do_not_optimize(c);
+	}, 5);
+	bench::report("julian_to_date (scalar, std::tm)", t_scalar);
+	bench::report("julian_to_ymdhms (batch)", t_batch);
+	std::cout << "   speedup = " << t_scalar/t_batch << "x\n";
+
+	t_scalar = bench::time_ms([&](){ for (size_t i=0; i<n; ++i) out[i] = flare::date_to_julian(tms[i]); bench::do_not_optimize(out); }, 5);
+	t_batch = bench::time_ms([&](){
+		flare::ymdhms_to_julian(c.year.data(), c.month.data(), c.day.data(), c.hour.data(), c.minute.data(), c.second.data(), n, out.data());
+		bench::do_not_optimize(out);
+	}, 5);
+	bench::report("date_to_julian (scalar, std::tm)", t_scalar);
+	bench::report("ymdhms_to_julian (batch)", t_batch);
+	std::cout << "   speedup = " << t_scalar/t_batch << "x\n";
+
+	const size_t ns = 100000;
+	std::vector<std::string> strs(ns);
+	for (size_t i=0; i<ns; ++i){
+		strs[i] = std::to_string(c.year[i]) + "-" + std::to_string(c.month[i]) + "-" + std::to_string(c.day[i]) + " "
+		        + std::to_string(c.hour[i]) + ":" + std::to_string(c.minute[i]) + ":" + std::to_string(int(c.second[i]));
+	}
+	std::cout << "Parsing " << ns << " date strings\n";
+	double sum = 0;
+	t_scalar = bench::time_ms([&](){ for (auto& s : strs) sum += flare::date_to_julian(flare::string_to_date(s)); }, 5);
+	t_batch = bench::time_ms([&](){ for (auto& s : strs) sum += flare::iso8601_to_julian(s); }, 5);
+	bench::do_not_optimize(sum);
+	bench::report("string_to_date + date_to_julian", t_scalar);
+	bench::report("iso8601_to_julian", t_batch);
+	std::cout << "   speedup = " << t_scalar/t_batch << "x\n";
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include "unpack.h"
+#include "bench_utils.h"
+
+// Compare fused unpacking of a packed full-globe slice (0.25 deg, int16) against 
+// the separate scalar passes that consumers used to run after readBlock 
+// (netCDF type conversion, then scale/offset, then fill replacement).
+
+int main(){
+	const size_t n = 720*1440*4; // 0.25 deg global grid
+	const float scale = 0.01f, offset = 273.15f;
+	const int16_t fill = -32767;
+
+	std::vector<int16_t> packed(n);
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> dist(-30000, 30000);
+	for (auto& x : packed) x = (rng()%10 == 0)? fill : dist(rng); // ~10% missing (ocean)
+
+	std::vector<float> out_ref(n), out(n);
+
+	auto separate = [&](){
+		for (size_t i=0; i<n; ++i) out_ref[i] = packed[i];   // type conversion (done by netCDF when reading as float)
+		for (size_t i=0; i<n; ++i) if (out_ref[i] == fill) out_ref[i] = NAN;
+		for (size_t i=0; i<n; ++i) out_ref[i] = out_ref[i]*scale + offset;
+		bench::do_not_optimize(out_ref);
+	};
+
+	auto fused = [&](){
+		flare::unpack<int16_t, float>(packed.data(), out.data(), n, scale, offset, fill, true);
+		bench::do_not_optimize(out);
+	};
+
+	auto fused_inplace = [&](){
+		for (size_t i=0; i<n; ++i) out[i] = packed[i];
+		flare::unpack_inplace<float>(out.data(), n, scale, offset, fill, true);
+		bench::do_not_optimize(out);
+	};
+
+	std::cout << "Unpacking " << n << " values (" <<
+#if defined(__AVX512F__)
+		"AVX-512"
+#elif defined(__AVX2__)
+		"AVX2"
+#else
+		"scalar"
+#endif
+		<< ")\n";
+
+	double t_sep = bench::time_ms(separate);
+	double t_fused = bench::time_ms(fused);
+	double t_inplace = bench::time_ms(fused_inplace);
+	bench::report("separate scalar passes", t_sep, n*sizeof(float));
+	bench::report("fused unpack (from int16)", t_fused, n*sizeof(float));
+	bench::report("convert + fused unpack (in place)", t_inplace, n*sizeof(float));
+	std::cout << "   speedup (fused) = " << t_sep/t_fused << "x\n";
+
+	// check results agree
+	for (size_t i=0; i<n; ++i){
+		if (std::isnan(out_ref[i]) != std::isnan(out[i]) || (!std::isnan(out[i]) && std::fabs(out[i]-out_ref[i]) > 1e-3)){
+			std::cout << "MISMATCH at " << i << ": " << out[i] << " vs " << out_ref[i] << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+#ifndef FLARE_FLARE_AXIS_INDEX_H
+#define FLARE_FLARE_AXIS_INDEX_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+namespace flare{
+
+/// @brief  Index lookups on a monotonic (ascending or descending) coordinate axis.
+///         If the axis is evenly spaced, lookups use the affine map i = (x-x0)/dx,
+///         followed by a check against the actual coordinate values (so results are
+///         identical to a binary search). Irregular axes fall back to binary search.
+///         The index is built for a particular coordinate vector; if it is queried with
+///         a vector it does not fit (different size or end points), binary search is used.
+struct AxisIndex {
+	bool regular = false;
+	bool descending = false;
+	size_t n = 0;
+	double x0 = 0, xlast = 0, dx = 0;
+
+	AxisIndex(){}
+
+	/// @param rel_tol   max deviation from the affine map (relative to dx) for the axis to be considered regular
+	explicit AxisIndex(const std::vector<double>& x, double rel_tol = 1e-3){
+		n = x.size();
+		if (n == 0) return;
+		x0 = x[0];
+		xlast = x[n-1];
+		descending = xlast < x0;
+		if (n < 2) return;
+		dx = (xlast - x0)/(n-1);
+		if (dx == 0) return;
+		regular = true;
+		for (size_t i=0; i<n; ++i){
+			if (std::fabs(x[i] - (x0 + i*dx)) > rel_tol*std::fabs(dx)){
+				regular = false;
+				break;
+			}
+		}
+	}
+
+	/// @brief  whether this index was built for x
+	bool fits(const std::vector<double>& x) const {
+		return x.size() == n && n > 0 && x[0] == x0 && x[n-1] == xlast;
+	}
+
+	/// @brief  number of elements that come strictly before v in axis order
+	///         (i.e. x[i] < v for ascending axes, x[i] > v for descending axes)
+	size_t count_before(const std::vector<double>& x, double v) const {
+		if (is_descending(x)) return count_if_prefix(x, v, std::greater<double>(), true);
+		else                  return count_if_prefix(x, v, std::less<double>(), true);
+	}
+
+	/// @brief  number of elements that come before v or are equal to it in axis order
+	///         (i.e. x[i] <= v for ascending axes, x[i] >= v for descending axes)
+	size_t count_before_eq(const std::vector<double>& x, double v) const {
+		if (is_descending(x)) return count_if_prefix(x, v, std::greater_equal<double>(), false);
+		else                  return count_if_prefix(x, v, std::less_equal<double>(), false);
+	}
+
+	/// @brief  index of the element nearest to v
+	size_t nearest(const std::vector<double>& x, double v) const {
+		size_t g = count_before(x, v);
+		if (g == 0) return 0;
+		if (g >= x.size()) return x.size()-1;
+		return (std::fabs(x[g]-v) < std::fabs(x[g-1]-v))? g : g-1;
+	}
+
+	private:
+	bool is_descending(const std::vector<double>& x) const {
+		if (fits(x)) return descending;
+		return x.size() > 1 && x.back() < x.front();
+	}
+
+	// number of leading elements for which before(x[i], v) is true.
+	// strict: whether 'before' is a strict comparison (affects the rounding of the initial guess)
+	template <class Cmp>
+	size_t count_if_prefix(const std::vector<double>& x, double v, Cmp before, bool strict) const {
+		if (!regular || !fits(x)){
+			return std::partition_point(x.begin(), x.end(), [&](double xi){ return before(xi, v); }) - x.begin();
+		}
+		double q = (v - x0)/dx;
+		size_t g;
+		if      (!(q > 0))    g = 0;  // (also catches NaN)
+		else if (q >= n)      g = n;
+		else if (strict)      g = size_t(std::ceil(q));
+		else                  g = size_t(std::floor(q)) + 1;
+		g = std::min(g, n);
+		// correct for rounding in the affine guess
+		while (g > 0 && !before(x[g-1], v)) --g;
+		while (g < n && before(x[g], v)) ++g;
+		return g;
+	}
+};
+
+} // namespace flare
+
+#endif
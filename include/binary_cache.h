@@ -0,0 +1,289 @@
+#ifndef FLARE_FLARE_BINARY_CACHE_H
+#define FLARE_FLARE_BINARY_CACHE_H
+
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "geocube.h"
+
+// Native binary cache of a GeoCube's trimmed region, for fast (memory-mapped) reloading.
+//
+// File layout:
+//    BinaryCacheHeader
+//    names:  var name, unit, dimnames ('\0'-terminated strings)
+//    coords: trimmed coordinate values of each dim (doubles, dims in order; time in days since base)
+//    data:   page-aligned, time-major: nt consecutive slices, each with the cube's dim order (time count = 1)
+
+namespace flare{
+
+struct BinaryCacheHeader {
+	char     magic[8] = {'F','L','A','R','E','B','C','\0'};
+	uint32_t version = 2;
+	uint32_t elem_size = 0;
+	uint32_t ndims = 0;
+	int32_t  lat_idx = -1, lon_idx = -1, t_idx = -1;
+	uint64_t dims[8] = {};          // dims of one slice (time count = 1)
+	uint64_t nt = 1;                // number of time slices
+	double   julian_base = 0;       // julian day of time base
+	double   tstep = 0;             // [days]
+	int32_t  calendar = 0;          // flare::Calendar of the time axis
+	double   calendar_base = 0;     // time base in days since the calendar's epoch
+	double   scale_factor = 1, add_offset = 0;
+	double   missing_value = 0;
+	uint64_t names_offset = 0, names_bytes = 0;
+	uint64_t coords_offset = 0;
+	uint64_t data_offset = 0, data_bytes = 0;
+};
+
+
+/// @brief            write the current spatial window of a cube, for time indices [t_start, t_start+t_count),
+///                   to a binary cache file. Data is read one slice at a time.
+/// @param t_count    number of time slices (0 = all from t_start)
+template <class T>
+void exportBinary(const GeoCube<T>& cube, const std::string& path, size_t t_start = 0, size_t t_count = 0){
+	BinaryCacheHeader h;
+	std::vector<size_t> sc = cube.sliceCounts();
+	if (sc.size() > 8) throw std::runtime_error("exportBinary: at most 8 dimensions are supported");
+
+	size_t nt_all = (cube.t_idx >= 0)? cube.coords_trimmed[cube.t_idx].size() : 1;
+	if (t_count == 0) t_count = nt_all - t_start;
+	if (t_start + t_count > nt_all) throw std::runtime_error("exportBinary: time range out of bounds");
+
+	h.elem_size = sizeof(T);
+	h.ndims = sc.size();
+	h.lat_idx = cube.lat_idx;
+	h.lon_idx = cube.lon_idx;
+	h.t_idx = cube.t_idx;
+	for (size_t i=0; i<sc.size(); ++i) h.dims[i] = sc[i];
+	h.nt = t_count;
+	if (cube.t_idx >= 0){
+		h.julian_base = cube.getJulianBase();
+		h.tstep = cube.getTstep();
+		h.calendar = int32_t(cube.getCalendar());
+		h.calendar_base = cube.getCalendarBase();
+	}
+	// slices unpacked on read are stored in physical units, with NaN as missing value
+	bool unpacked = false;
+	if constexpr (std::is_floating_point<T>::value) unpacked = cube.unpack_on_read;
+	h.scale_factor = unpacked? 1 : cube.scale_factor;
+	h.add_offset = unpacked? 0 : cube.add_offset;
+	h.missing_value = unpacked? std::numeric_limits<double>::quiet_NaN() : double(cube.missing_value);
+
+	// names
+	std::string names = cube.name + '\0' + cube.unit + '\0';
+	for (auto& d : cube.dimnames) names += d + '\0';
+
+	// coords (time restricted to the exported range)
+	std::vector<double> coordvals;
+	for (size_t i=0; i<sc.size(); ++i){
+		auto& x = cube.coords_trimmed[i];
+		if (int(i) == cube.t_idx) coordvals.insert(coordvals.end(), x.begin()+t_start, x.begin()+t_start+t_count);
+		else coordvals.insert(coordvals.end(), x.begin(), x.end());
+	}
+
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t slice_size = cube.sliceSize();
+	h.names_offset = sizeof(BinaryCacheHeader);
+	h.names_bytes = names.size();
+	h.coords_offset = (h.names_offset + h.names_bytes + 7)/8*8;
+	h.data_offset = (h.coords_offset + coordvals.size()*sizeof(double) + page-1)/page*page;
+	h.data_bytes = t_count*slice_size*sizeof(T);
+
+	std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+	if (!fout) throw std::runtime_error("exportBinary: cannot open " + path + " for writing");
+
+	fout.write((const char*)&h, sizeof(h));
+	fout.write(names.data(), names.size());
+	fout.seekp(h.coords_offset);
+	fout.write((const char*)coordvals.data(), coordvals.size()*sizeof(double));
+	fout.seekp(h.data_offset);
+
+	std::vector<T> slice(slice_size);
+	for (size_t k=0; k<t_count; ++k){
+		cube.readSliceInto(t_start + k, slice.data());
+		fout.write((const char*)slice.data(), slice_size*sizeof(T));
+	}
+	if (!fout) throw std::runtime_error("exportBinary: error writing " + path);
+}
+
+
+/// @brief  Read-only, memory-mapped view of a binary cache file. Slices are returned as pointers
+///         into the mapped pages (no copy), and the mapping is shared by all processes that open the file.
+template <class T>
+class MappedGeoCube {
+	public:
+	std::string name;
+	std::string unit;
+	std::vector<std::string> dimnames;
+	std::vector<std::vector<double>> coords_trimmed;
+	int lat_idx = -1, lon_idx = -1, t_idx = -1;
+	float scale_factor = 1, add_offset = 0;
+	T missing_value;
+
+	private:
+	BinaryCacheHeader h;
+	void*  map = nullptr;
+	size_t map_bytes = 0;
+	const T* data = nullptr;
+	AxisIndex t_index;
+
+	public:
+	MappedGeoCube(){}
+
+	explicit MappedGeoCube(const std::string& path){
+		open(path);
+	}
+
+	~MappedGeoCube(){
+		close();
+	}
+
+	MappedGeoCube(const MappedGeoCube&) = delete;
+	MappedGeoCube& operator=(const MappedGeoCube&) = delete;
+
+	/// @brief   map a binary cache file. All offsets and sizes in the header are checked against the
+	///          file, so that a corrupt or foreign file is rejected instead of read out of bounds.
+	void open(const std::string& path){
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error("MappedGeoCube: cannot open " + path);
+		struct stat st;
+		if (fstat(fd, &st) != 0){
+			::close(fd);
+			throw std::runtime_error("MappedGeoCube: cannot stat " + path);
+		}
+		size_t bytes = st.st_size;
+		void* m = (bytes > 0)? mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+		::close(fd); // the mapping stays valid
+		if (m == MAP_FAILED) throw std::runtime_error("MappedGeoCube: cannot map " + path);
+
+		// unmapped on any error below
+		struct Unmap {
+			void* p; size_t n;
+			~Unmap(){ if (p) munmap(p, n); }
+		} guard{m, bytes};
+		auto fail = [&](const std::string& what){ throw std::runtime_error("MappedGeoCube: " + path + ": " + what); };
+		auto within = [&](uint64_t offset, uint64_t n){ return offset <= bytes && n <= bytes - offset; };
+
+		if (bytes < sizeof(BinaryCacheHeader)) fail("file is too small");
+		BinaryCacheHeader hd;
+		std::memcpy(&hd, m, sizeof(hd));
+		if (std::memcmp(hd.magic, "FLAREBC", 8) != 0 || hd.version != 2) fail("not a flare binary cache (v2)");
+		if (hd.elem_size != sizeof(T)) fail("element size does not match");
+		if (hd.ndims > 8) fail("too many dimensions");
+		for (int32_t idx : {hd.lat_idx, hd.lon_idx, hd.t_idx}){
+			if (idx < -1 || idx >= int32_t(hd.ndims)) fail("dimension index out of range");
+		}
+
+		// sizes, bounded by the file size so that the products below cannot overflow
+		uint64_t ncoords = 0, slice_elems = 1;
+		for (size_t i=0; i<hd.ndims; ++i){
+			uint64_t n = (int(i) == hd.t_idx)? hd.nt : hd.dims[i];
+			if (n > bytes) fail("dimension too large");
+			ncoords += n;
+			if (hd.dims[i] > 0 && slice_elems > bytes/hd.dims[i]) fail("dimensions too large");
+			slice_elems *= hd.dims[i];
+		}
+		if (hd.nt > bytes || (slice_elems > 0 && hd.nt > bytes/(slice_elems*sizeof(T)))) fail("data does not fit the file");
+		if (hd.names_offset < sizeof(BinaryCacheHeader) || !within(hd.names_offset, hd.names_bytes)) fail("names out of range");
+		if (hd.coords_offset % sizeof(double) != 0 || !within(hd.coords_offset, ncoords*sizeof(double))) fail("coordinates out of range");
+		if (hd.data_offset % sizeof(T) != 0 || hd.data_bytes != hd.nt*slice_elems*sizeof(T) || !within(hd.data_offset, hd.data_bytes)) fail("file is truncated");
+
+		const char* base = (const char*)m;
+
+		// names ('\0'-terminated, within [names_offset, names_offset+names_bytes))
+		const char* p = base + hd.names_offset;
+		const char* end = p + hd.names_bytes;
+		auto next_name = [&](){
+			const char* z = (const char*)std::memchr(p, '\0', end - p);
+			if (!z) fail("names are not terminated");
+			std::string str(p, z);
+			p = z + 1;
+			return str;
+		};
+		std::string _name = next_name(), _unit = next_name();
+		std::vector<std::string> _dimnames;
+		for (size_t i=0; i<hd.ndims; ++i) _dimnames.push_back(next_name());
+
+		// coords
+		const double* c = (const double*)(base + hd.coords_offset);
+		std::vector<std::vector<double>> _coords;
+		for (size_t i=0; i<hd.ndims; ++i){
+			size_t n = (int(i) == hd.t_idx)? hd.nt : hd.dims[i];
+			_coords.push_back(std::vector<double>(c, c+n));
+			c += n;
+		}
+
+		h = hd;
+		name = std::move(_name);
+		unit = std::move(_unit);
+		dimnames = std::move(_dimnames);
+		coords_trimmed = std::move(_coords);
+		lat_idx = h.lat_idx;
+		lon_idx = h.lon_idx;
+		t_idx = h.t_idx;
+		scale_factor = h.scale_factor;
+		add_offset = h.add_offset;
+		missing_value = T(h.missing_value);
+		t_index = (t_idx >= 0)? AxisIndex(coords_trimmed[t_idx]) : AxisIndex();
+		map = m;
+		map_bytes = bytes;
+		data = (const T*)(base + h.data_offset);
+		guard.p = nullptr;
+	}
+
+	void close(){
+		if (map) munmap(map, map_bytes);
+		map = nullptr;
+		data = nullptr;
+	}
+
+	/// @brief   number of time slices
+	size_t nt() const {
+		return h.nt;
+	}
+
+	/// @brief   dims of a single time slice
+	std::vector<size_t> sliceCounts() const {
+		return std::vector<size_t>(h.dims, h.dims + h.ndims);
+	}
+
+	size_t sliceSize() const {
+		size_t n = 1;
+		for (size_t i=0; i<h.ndims; ++i) n *= h.dims[i];
+		return n;
+	}
+
+	/// @brief   pointer to the data of time slice t (zero copy)
+	const T* slice(size_t t) const {
+		if (t >= h.nt) throw std::runtime_error("MappedGeoCube: time index out of range");
+		return data + t*sliceSize();
+	}
+
+	double t_index_to_julian(size_t i) const {
+		return days_since_to_julian(Calendar(h.calendar), coords_trimmed[t_idx][i], h.julian_base, h.calendar_base);
+	}
+
+	/// @brief   same as GeoCube::julian_to_index
+	size_t julian_to_index(double j, bool periodic, bool centred_t) const {
+		if (t_idx < 0) throw std::runtime_error("julian_to_index: no time vector in file");
+		auto& tvec = coords_trimmed[t_idx];
+		double t = julian_to_days_since(Calendar(h.calendar), j, h.julian_base, h.calendar_base);
+		if (centred_t) t += h.tstep/2;
+		double DeltaT = tvec[tvec.size()-1] - tvec[0] + h.tstep;
+		if (periodic) t = tvec[0] + utils::positive_fmod(t - tvec[0], DeltaT);
+		int idx = int(t_index.count_before(tvec, t)) - 1;
+		return std::clamp(idx, 0, int(tvec.size()-1));
+	}
+};
+
+} // namespace flare
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef FLARE_FLARE_CHUNK_READER_H
+#define FLARE_FLARE_CHUNK_READER_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+#ifdef FLARE_HAVE_HDF5
+#include <hdf5.h>
+#include <zlib.h>
+#endif
+
+#include "ncfilepp.h"
+#include "thread_pool.h"
+
+// Parallel decompression of chunked, deflate-compressed variables.
+// netCDF/HDF5 run the filter pipeline (inflate, unshuffle) serially inside H5Dread, under the
+// library lock. ChunkReader instead reads the raw (compressed) chunks that overlap a hyperslab with
+// HDF5 direct chunk I/O, and inflates, unshuffles and scatters them into the output on a thread pool.
+// Only the raw chunk reads hold the lock, so decompression of one chunk overlaps with reading the next.
+// Requires HDF5 >= 1.10.5 and zlib: compile with -DFLARE_HAVE_HDF5 and link -lhdf5 -lz. Without it
+// (or for unsupported filters, types or strides) ok() / read() return false, and callers fall back to getVar.
+
+namespace flare{
+
+class ChunkReader {
+	public:
+	std::vector<size_t> dims, chunk_dims;
+	size_t elem_size = 0;
+
+	private:
+	bool usable = false;
+	int ncid;                     // file id for netcdf_mutex (HDF5 calls are serialized with netCDF's)
+#ifdef FLARE_HAVE_HDF5
+	hid_t file = -1, dset = -1;
+	std::vector<H5Z_filter_t> filters;   // in pipeline (write) order
+	std::vector<char> fill;              // fill value of unallocated chunks
+	H5T_class_t type_class = H5T_NO_CLASS;
+	bool is_signed = false, native_order = false;
+#endif
+
+	public:
+	/// @param path      netCDF-4 file
+	/// @param var_path  path of the variable's dataset in the file (e.g. "/tas")
+	/// @param _ncid     netCDF id of the file or of a group in it (selects the lock)
+	ChunkReader(const std::string& path, const std::string& var_path, int _ncid = -1) : ncid(root_ncid(_ncid)) {
+#ifdef FLARE_HAVE_HDF5
+		std::lock_guard<std::mutex> lock(netcdf_mutex(ncid));
+		H5E_BEGIN_TRY {
+			// the file is already open in netCDF; the file close degree must match the one netCDF uses
+			for (H5F_close_degree_t degree : {H5F_CLOSE_WEAK, H5F_CLOSE_SEMI}){
+				hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+				H5Pset_fclose_degree(fapl, degree);
+				file = H5Fopen(path.c_str(), H5F_ACC_RDONLY, fapl);
+				H5Pclose(fapl);
+				if (file >= 0) break;
+			}
+			if (file >= 0) dset = H5Dopen2(file, var_path.c_str(), H5P_DEFAULT);
+		} H5E_END_TRY;
+		if (dset < 0) return;
+
+		hid_t dcpl = H5Dget_create_plist(dset);
+		if (H5Pget_layout(dcpl) != H5D_CHUNKED){
+			H5Pclose(dcpl);
+			return;
+		}
+		hid_t space = H5Dget_space(dset);
+		int nd = H5Sget_simple_extent_ndims(space);
+		std::vector<hsize_t> d(nd), cd(nd);
+		H5Sget_simple_extent_dims(space, d.data(), nullptr);
+		H5Pget_chunk(dcpl, nd, cd.data());
+		H5Sclose(space);
+		dims.assign(d.begin(), d.end());
+		chunk_dims.assign(cd.begin(), cd.end());
+
+		hid_t dtype = H5Dget_type(dset);
+		elem_size = H5Tget_size(dtype);
+		type_class = H5Tget_class(dtype);
+		is_signed = (type_class == H5T_INTEGER && H5Tget_sign(dtype) == H5T_SGN_2);
+		native_order = (H5Tget_order(dtype) == H5Tget_order(H5T_NATIVE_INT));
+
+		bool supported = (type_class == H5T_FLOAT || type_class == H5T_INTEGER) && native_order;
+		int nf = H5Pget_nfilters(dcpl);
+		for (int i=0; i<nf; ++i){
+			unsigned flags, config, cd_values[8];
+			size_t nvalues = 8;
+			char fname[64];
+			H5Z_filter_t f = H5Pget_filter2(dcpl, i, &flags, &nvalues, cd_values, sizeof(fname), fname, &config);
+			if (f != H5Z_FILTER_DEFLATE && f != H5Z_FILTER_SHUFFLE) supported = false;
+			filters.push_back(f);
+		}
+
+		fill.assign(elem_size, 0);
+		H5D_fill_value_t fstatus;
+		if (H5Pfill_value_defined(dcpl, &fstatus) >= 0 && fstatus != H5D_FILL_VALUE_UNDEFINED) H5Pget_fill_value(dcpl, dtype, fill.data());
+		H5Tclose(dtype);
+		H5Pclose(dcpl);
+		usable = supported;
+#else
+		(void)path; (void)var_path;
+#endif
+	}
+
+	~ChunkReader(){
+#ifdef FLARE_HAVE_HDF5
+		std::lock_guard<std::mutex> lock(netcdf_mutex(ncid));
+		if (dset >= 0) H5Dclose(dset);
+		if (file >= 0) H5Fclose(file);
+#endif
+	}
+
+	ChunkReader(const ChunkReader&) = delete;
+	ChunkReader& operator=(const ChunkReader&) = delete;
+
+	/// @brief   whether the variable can be read through this reader (chunked, with only deflate/shuffle filters)
+	bool ok() const {
+		return usable;
+	}
+
+	/// @brief   read the hyperslab [s, s+c) into out, decompressing chunks on pool (serially if nullptr).
+	///          Must not be called from a task running on the same pool.
+	/// @param imap  layout of out (as in netCDF's varm functions, innermost dim contiguous), or nullptr for row-major c
+	/// @return  false if the hyperslab cannot be read this way (unsupported filter, type mismatch, strides != 1)
+	template <class U>
+	bool read(const std::vector<size_t>& s, const std::vector<size_t>& c, const std::vector<ptrdiff_t>& st, U* out, ThreadPool* pool = nullptr, const std::vector<ptrdiff_t>* imap = nullptr) const {
+#ifdef FLARE_HAVE_HDF5
+		if (!usable || !type_matches<U>() || s.size() != dims.size()) return false;
+		for (auto x : st) if (x != 1) return false;
+		if (imap && (imap->size() != dims.size() || imap->back() != 1)) return false;
+
+		size_t nd = dims.size();
+		std::vector<size_t> first(nd), nchunks_d(nd);
+		size_t nchunks = 1;
+		for (size_t d=0; d<nd; ++d){
+			if (c[d] == 0) return true;
+			first[d] = s[d]/chunk_dims[d];
+			nchunks_d[d] = (s[d] + c[d] - 1)/chunk_dims[d] - first[d] + 1;
+			nchunks *= nchunks_d[d];
+		}
+		size_t chunk_elems = 1;
+		for (auto x : chunk_dims) chunk_elems *= x;
+		std::vector<size_t> ostr(nd, 1); // strides of out
+		for (int d=int(nd)-2; d>=0; --d) ostr[d] = imap? (*imap)[d] : ostr[d+1]*c[d+1];
+
+		auto work = [&](size_t b, size_t e){
+			std::vector<unsigned char> raw, tmp, plain(chunk_elems*elem_size);
+			std::vector<hsize_t> off(nd);
+			for (size_t k=b; k<e; ++k){
+				// chunk coordinates of the k-th chunk touched (row-major over the touched range)
+				size_t r = k;
+				for (int d=int(nd)-1; d>=0; --d){
+					off[d] = (first[d] + r%nchunks_d[d])*chunk_dims[d];
+					r /= nchunks_d[d];
+				}
+
+				uint32_t fmask = 0;
+				haddr_t addr = HADDR_UNDEF;
+				hsize_t csize = 0;
+				{
+					std::lock_guard<std::mutex> lock(netcdf_mutex(ncid));
+					if (H5Dget_chunk_info_by_coord(dset, off.data(), &fmask, &addr, &csize) < 0) throw std::runtime_error("ChunkReader: cannot locate chunk");
+					if (addr != HADDR_UNDEF && csize > 0){
+						raw.resize(csize);
+						if (H5Dread_chunk(dset, H5P_DEFAULT, off.data(), &fmask, raw.data()) < 0) throw std::runtime_error("ChunkReader: cannot read chunk");
+					}
+				}
+				if (addr == HADDR_UNDEF || csize == 0){
+					for (size_t i=0; i<chunk_elems; ++i) std::memcpy(plain.data() + i*elem_size, fill.data(), elem_size);
+				}
+				else decode(raw, tmp, fmask, plain);
+				scatter((const U*)plain.data(), off, s, c, ostr, out);
+			}
+		};
+		if (pool) pool->parallel_for(nchunks, work);
+		else      work(0, nchunks);
+		return true;
+#else
+		(void)s; (void)c; (void)st; (void)out; (void)pool; (void)imap;
+		return false;
+#endif
+	}
+
+	private:
+#ifdef FLARE_HAVE_HDF5
+	template <class U>
+	bool type_matches() const {
+		if (sizeof(U) != elem_size) return false;
+		if (std::is_floating_point<U>::value) return type_class == H5T_FLOAT;
+		return type_class == H5T_INTEGER && std::is_signed<U>::value == is_signed;
+	}
+
+	// undo the filter pipeline (in reverse order): inflate, unshuffle. Filters with their bit set in fmask were skipped on write.
+	void decode(std::vector<unsigned char>& raw, std::vector<unsigned char>& tmp, uint32_t fmask, std::vector<unsigned char>& plain) const {
+		std::vector<unsigned char>* cur = &raw;
+		for (int i=int(filters.size())-1; i>=0; --i){
+			if (fmask & (1u << i)) continue;
+			if (filters[i] == H5Z_FILTER_DEFLATE){
+				tmp.resize(plain.size());
+				uLongf len = tmp.size();
+				if (uncompress(tmp.data(), &len, cur->data(), cur->size()) != Z_OK || len != tmp.size())
+					throw std::runtime_error("ChunkReader: inflate failed");
+			}
+			else { // shuffle: byte b of element j is at b*n + j
+				size_t n = cur->size()/elem_size;
+				tmp.resize(cur->size());
+				const unsigned char* src = cur->data();
+				for (size_t bt=0; bt<elem_size; ++bt)
+					for (size_t j=0; j<n; ++j) tmp[j*elem_size + bt] = src[bt*n + j];
+			}
+			std::swap(*cur, tmp);
+		}
+		if (cur->size() != plain.size()) throw std::runtime_error("ChunkReader: decoded chunk has the wrong size");
+		std::swap(*cur, plain);
+	}
+
+	// copy the part of a chunk (at offset off) that overlaps the hyperslab [s, s+c) into out (with strides ostr)
+	template <class U>
+	void scatter(const U* chunk, const std::vector<hsize_t>& off, const std::vector<size_t>& s, const std::vector<size_t>& c, const std::vector<size_t>& ostr, U* out) const {
+		size_t nd = dims.size();
+		std::vector<size_t> lo(nd), hi(nd), cstr(nd, 1);
+		for (int d=int(nd)-2; d>=0; --d) cstr[d] = cstr[d+1]*chunk_dims[d+1];
+		for (size_t d=0; d<nd; ++d){
+			lo[d] = std::max<size_t>(off[d], s[d]);
+			hi[d] = std::min<size_t>({off[d] + chunk_dims[d], s[d] + c[d], dims[d]});
+		}
+		size_t run = hi[nd-1] - lo[nd-1];
+		std::vector<size_t> idx(lo);
+		while (true){
+			size_t ci = 0, oi = 0;
+			for (size_t d=0; d<nd; ++d){
+				ci += (idx[d] - off[d])*cstr[d];
+				oi += (idx[d] - s[d])*ostr[d];
+			}
+			std::memcpy(out + oi, chunk + ci, run*sizeof(U));
+			int d = int(nd)-2;
+			for (; d>=0; --d){
+				if (++idx[d] < hi[d]) break;
+				idx[d] = lo[d];
+			}
+			if (d < 0) break;
+		}
+	}
+#endif
+};
+
+} // namespace flare
+
+#endif
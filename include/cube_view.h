@@ -0,0 +1,200 @@
+#ifndef FLARE_FLARE_CUBE_VIEW_H
+#define FLARE_FLARE_CUBE_VIEW_H
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "geocube.h"
+
+namespace flare{
+
+/// @brief  Non-owning view of an n-dimensional block of data (e.g. the data of a GeoCube after readBlock()),
+///         with its shape, strides and coordinates. Sub-views (a time slice, a lat/lon window, a coordinate
+///         range) only adjust the data pointer, shape and coordinate pointers, so slicing a loaded block does
+///         not copy data. A view is valid as long as the underlying data and coordinates are not reallocated
+///         (e.g. by another readBlock() with a different shape).
+///         Use CubeView<const T> for read-only views.
+template <class T>
+class CubeView {
+	public:
+	using value_type = std::remove_const_t<T>;
+
+	T* data = nullptr;                   // first element
+	std::vector<size_t> shape;
+	std::vector<ptrdiff_t> strides;      // [elements]
+	std::vector<const double*> coords;   // coordinate values along each dim (shape[d] values, or nullptr if unknown)
+	int lat_idx = -1, lon_idx = -1, t_idx = -1;
+	value_type missing_value = value_type();
+
+	CubeView(){}
+
+	/// @brief   view of a contiguous row-major array
+	CubeView(T* _data, const std::vector<size_t>& _shape)
+		: data(_data), shape(_shape), strides(_shape.size(), 1), coords(_shape.size(), nullptr) {
+		for (int d=int(shape.size())-2; d>=0; --d) strides[d] = strides[d+1]*shape[d+1];
+	}
+
+	/// @brief   (implicit) conversion of a view to a read-only view
+	template <class U, class = std::enable_if_t<std::is_same<const U, T>::value && !std::is_same<U, T>::value>>
+	CubeView(const CubeView<U>& v)
+		: data(v.data), shape(v.shape), strides(v.strides), coords(v.coords),
+		  lat_idx(v.lat_idx), lon_idx(v.lon_idx), t_idx(v.t_idx), missing_value(v.missing_value) {}
+
+	size_t size() const {
+		return std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+	}
+
+	/// @brief   whether the elements are contiguous in row-major order (so data[0, size()) can be used directly)
+	bool contiguous() const {
+		ptrdiff_t s = 1;
+		for (int d=int(shape.size())-1; d>=0; --d){
+			if (shape[d] > 1 && strides[d] != s) return false;
+			s *= shape[d];
+		}
+		return true;
+	}
+
+	T& at(const std::vector<size_t>& idx) const {
+		ptrdiff_t o = 0;
+		for (size_t d=0; d<shape.size(); ++d) o += idx[d]*strides[d];
+		return data[o];
+	}
+
+	/// @brief   sub-view of the index range [start, start+count) along an axis
+	CubeView range(size_t axis, size_t start, size_t count) const {
+		if (axis >= shape.size() || start + count > shape[axis]) throw std::runtime_error("CubeView: range out of bounds on axis " + std::to_string(axis));
+		CubeView v = *this;
+		v.data += ptrdiff_t(start)*strides[axis];
+		v.shape[axis] = count;
+		if (v.coords[axis]) v.coords[axis] += start;
+		return v;
+	}
+
+	/// @brief   time slice t (the time dim is kept, with count 1)
+	CubeView timeSlice(size_t t) const {
+		if (t_idx < 0) throw std::runtime_error("CubeView: no time dimension");
+		return range(t_idx, t, 1);
+	}
+
+	/// @brief   lat/lon window, as index ranges relative to this view
+	CubeView window(size_t lat_start, size_t lat_count, size_t lon_start, size_t lon_count) const {
+		return range(lat_idx, lat_start, lat_count).range(lon_idx, lon_start, lon_count);
+	}
+
+	/// @brief   sub-view spanning the coordinate range [lo, hi] along an axis, with the same bracketing as
+	///          GeoCube::setCoordBounds (from the last value before lo to the first value beyond hi)
+	CubeView coordRange(size_t axis, double lo, double hi) const {
+		const double* x = coords[axis];
+		size_t n = shape[axis];
+		if (!x) throw std::runtime_error("CubeView: no coordinates on axis " + std::to_string(axis));
+		bool descending = n > 1 && x[n-1] < x[0];
+		auto count_before = [&](double v, bool eq){
+			return size_t(std::partition_point(x, x+n, [&](double xi){
+				return descending? (eq? xi >= v : xi > v) : (eq? xi <= v : xi < v);
+			}) - x);
+		};
+		long first = long(count_before(descending? hi : lo, false)) - 1;
+		size_t start = std::max(first, 0L);
+		size_t end = std::min(count_before(descending? lo : hi, true), n-1);
+		return range(axis, start, end - start + 1);
+	}
+
+	/// @brief   coordinate values along an axis
+	std::vector<double> coordValues(size_t axis) const {
+		if (!coords[axis]) return std::vector<double>();
+		return std::vector<double>(coords[axis], coords[axis] + shape[axis]);
+	}
+
+	/// @brief   call f(p, n, offset) for each contiguous run of elements along the innermost dim,
+	///          where offset is the position of the run in row-major order (runs are of length 1 if
+	///          the innermost dim is not contiguous)
+	template <class F>
+	void forEachRun(F f) const {
+		size_t nd = shape.size();
+		if (nd == 0 || size() == 0) return;
+		if (contiguous()){
+			f(data, size(), size_t(0));
+			return;
+		}
+		size_t run = (strides[nd-1] == 1)? shape[nd-1] : 1;
+		size_t nruns = size()/run;
+		std::vector<size_t> idx(nd, 0);
+		size_t inner_dims = (run > 1)? nd-1 : nd; // dims iterated over
+		for (size_t r=0; r<nruns; ++r){
+			ptrdiff_t o = 0;
+			for (size_t d=0; d<inner_dims; ++d) o += idx[d]*strides[d];
+			f(data + o, run, r*run);
+			for (int d=int(inner_dims)-1; d>=0; --d){
+				if (++idx[d] < shape[d]) break;
+				idx[d] = 0;
+			}
+		}
+	}
+
+	/// @brief   copy the elements in row-major order to dst (which must hold size() elements)
+	void copyTo(value_type* dst) const {
+		forEachRun([dst](T* p, size_t n, size_t offset){ std::copy(p, p+n, dst + offset); });
+	}
+
+	std::vector<value_type> toVector() const {
+		std::vector<value_type> out(size());
+		copyTo(out.data());
+		return out;
+	}
+
+	/// @brief   elements in row-major order: data itself if the view is contiguous, else a copy packed into buffer
+	const value_type* packed(std::vector<value_type>& buffer) const {
+		if (contiguous()) return data;
+		buffer.resize(size());
+		copyTo(buffer.data());
+		return buffer.data();
+	}
+};
+
+
+// coordinate pointers of the data currently held by a cube (nullptr along strided dims,
+// whose values are not contiguous in the cube's coordinate arrays)
+template <class T>
+std::vector<const double*> cube_view_coords(const GeoCube<T>& cube){
+	auto& s = cube.getStarts();
+	auto& c = cube.getCounts();
+	auto& st = cube.getStrides();
+	std::vector<const double*> coords(c.size(), nullptr);
+	for (size_t d=0; d<c.size(); ++d){
+		if (st[d] != 1) continue;
+		if (int(d) == cube.t_idx || int(d) == cube.unlim_idx){
+			// time/unlimited indices refer to the (converted) time axis in coords_trimmed
+			auto& x = cube.coords_trimmed[d];
+			if (s[d] + c[d] <= x.size()) coords[d] = x.data() + s[d];
+		}
+		else if (cube.coords_trimmed[d].size() == c[d]) coords[d] = cube.coords_trimmed[d].data();
+		else if (s[d] + c[d] <= cube.coords[d].size()) coords[d] = cube.coords[d].data() + s[d];
+	}
+	return coords;
+}
+
+/// @brief   view of the data currently held by a cube (e.g. the block read by the last readBlock())
+template <class T>
+CubeView<T> view(GeoCube<T>& cube){
+	if (cube.vec.size() != std::accumulate(cube.getCounts().begin(), cube.getCounts().end(), size_t(1), std::multiplies<size_t>()))
+		throw std::runtime_error("view: cube data does not match its hyperslab");
+	CubeView<T> v(cube.vec.data(), cube.getCounts());
+	v.coords = cube_view_coords(cube);
+	v.lat_idx = cube.lat_idx;
+	v.lon_idx = cube.lon_idx;
+	v.t_idx = cube.t_idx;
+	v.missing_value = cube.missing_value;
+	return v;
+}
+
+template <class T>
+CubeView<const T> view(const GeoCube<T>& cube){
+	return view(const_cast<GeoCube<T>&>(cube));
+}
+
+} // namespace flare
+
+#endif
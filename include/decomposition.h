@@ -0,0 +1,520 @@
+#ifndef FLARE_FLARE_DECOMPOSITION_H
+#define FLARE_FLARE_DECOMPOSITION_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <tuple>
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "geocube.h"
+
+namespace flare{
+
+/// @brief  A rectangular lat/lon tile, as index ranges on the full lat/lon axes
+struct Tile {
+	size_t lat_start = 0, lat_count = 0;
+	size_t lon_start = 0, lon_count = 0;
+	size_t weight = 0;   // number of valid points in the tile
+	int rank = -1;       // worker that owns the tile
+};
+
+
+/// @brief  Decomposition of a lat/lon window into tiles, assigned to workers (ranks)
+struct Decomposition {
+	size_t lat_start = 0, lat_count = 0;  // window covered (index ranges on the full axes)
+	size_t lon_start = 0, lon_count = 0;
+	int nranks = 1;
+	int ranks_per_node = 1;               // nodes hold consecutive ranks [k*ranks_per_node, (k+1)*ranks_per_node)
+	std::vector<Tile> tiles;              // tiles with at least one valid point, ordered by rank, then position
+
+	std::vector<Tile> tilesOf(int rank) const {
+		std::vector<Tile> out;
+		for (auto& t : tiles) if (t.rank == rank) out.push_back(t);
+		return out;
+	}
+
+	/// @brief   number of valid points assigned to a rank
+	size_t load(int rank) const {
+		size_t w = 0;
+		for (auto& t : tiles) if (t.rank == rank) w += t.weight;
+		return w;
+	}
+
+	/// @brief   max load / mean load (1 = perfectly balanced)
+	double imbalance() const {
+		size_t total = 0, max_load = 0;
+		for (int r=0; r<nranks; ++r){
+			size_t l = load(r);
+			total += l;
+			max_load = std::max(max_load, l);
+		}
+		return (total == 0)? 1 : double(max_load)*nranks/total;
+	}
+
+	/// @brief   bounding box of the tiles of ranks [rank0, rank0+n) (weight = 0 if they have no tiles)
+	Tile bounds(int rank0, int n) const {
+		Tile b;
+		size_t lat_end = 0, lon_end = 0;
+		b.lat_start = b.lon_start = SIZE_MAX;
+		for (auto& t : tiles){
+			if (t.rank < rank0 || t.rank >= rank0 + n) continue;
+			b.lat_start = std::min(b.lat_start, t.lat_start);
+			b.lon_start = std::min(b.lon_start, t.lon_start);
+			lat_end = std::max(lat_end, t.lat_start + t.lat_count);
+			lon_end = std::max(lon_end, t.lon_start + t.lon_count);
+			b.weight += t.weight;
+		}
+		if (b.weight == 0) return Tile();
+		b.lat_count = lat_end - b.lat_start;
+		b.lon_count = lon_end - b.lon_start;
+		return b;
+	}
+
+	void print() const {
+		std::cout << "Decomposition > " << tiles.size() << " tiles on " << nranks << " ranks (" << ranks_per_node << " per node), imbalance = " << imbalance() << "\n";
+		for (auto& t : tiles){
+			std::cout << "   rank " << t.rank << ": lat [" << t.lat_start << ", " << t.lat_start + t.lat_count << ") x lon ["
+			          << t.lon_start << ", " << t.lon_start + t.lon_count << "), " << t.weight << " points\n";
+		}
+	}
+};
+
+
+// rectangle [i0, i1) x [j0, j1) of window indices
+struct TileRect {
+	size_t i0, i1, j0, j1;
+};
+
+// recursive coordinate bisection: split r into one rectangle per part, with numbers of valid points proportional
+// to the part sizes. Each cut goes across the longer side, at the row/column that best matches the target share.
+// weight(r) gives the number of valid points in a rectangle.
+template <class W>
+void bisect(const TileRect& r, const std::vector<size_t>& sizes, size_t p0, size_t p1, W weight, std::vector<TileRect>& out){
+	if (p1 - p0 == 1){
+		out[p0] = r;
+		return;
+	}
+	size_t pm = (p0 + p1)/2;
+	size_t n_left = 0, n_all = 0;
+	for (size_t p=p0; p<p1; ++p){
+		n_all += sizes[p];
+		if (p < pm) n_left += sizes[p];
+	}
+	bool cut_lat = (r.i1 - r.i0 > r.j1 - r.j0) || (r.j1 - r.j0 < 2);
+	size_t lo = cut_lat? r.i0 : r.j0, hi = cut_lat? r.i1 : r.j1;
+	auto part = [&](size_t c0, size_t c1){
+		return cut_lat? TileRect{c0, c1, r.j0, r.j1} : TileRect{r.i0, r.i1, c0, c1};
+	};
+	size_t cut = lo;
+	if (hi - lo >= 2){
+		double target = double(weight(r))*n_left/n_all;
+		if (weight(r) == 0) target = 0, cut = lo + (hi - lo)*n_left/n_all; // (no valid points: split by area)
+		else {
+			double best = -1;
+			for (size_t c=lo+1; c<hi; ++c){
+				double err = std::fabs(weight(part(lo, c)) - target);
+				if (best < 0 || err < best){
+					best = err;
+					cut = c;
+				}
+			}
+		}
+	}
+	else if (hi - lo == 1) cut = hi; // (a single cell: the right parts get empty rectangles)
+	bisect(part(lo, cut), sizes, p0, pm, weight, out);
+	bisect(part(cut, hi), sizes, pm, p1, weight, out);
+}
+
+/// @brief                  split a lat/lon window into tiles and assign them to ranks, balancing the number of valid
+///                         points per rank. The window is first bisected recursively into one rectangle per node,
+///                         then each node's rectangle into one per rank, and each rank's rectangle into tiles, which
+///                         are shrunk to their valid points. The tiles of a node are therefore contiguous, and its
+///                         bounding box (the slab read by a CollectiveReader) does not overlap with those of other nodes.
+/// @param tiles_per_rank   number of tiles per rank (tiles without valid points are dropped)
+/// @param valid            optional mask over the window (lat_count x lon_count, lat-major): nonzero = point to be
+///                         simulated (e.g. land). If empty, all points are valid.
+/// @param ranks_per_node   number of (consecutive) ranks per node
+inline Decomposition decompose(size_t lat_start, size_t lat_count, size_t lon_start, size_t lon_count, int nranks,
+                               size_t tiles_per_rank = 4, const std::vector<char>& valid = std::vector<char>(), int ranks_per_node = 1){
+	if (nranks < 1 || lat_count == 0 || lon_count == 0) throw std::runtime_error("decompose: empty window or no ranks");
+	if (!valid.empty() && valid.size() != lat_count*lon_count) throw std::runtime_error("decompose: mask does not match the window");
+
+	Decomposition dec;
+	dec.lat_start = lat_start; dec.lat_count = lat_count;
+	dec.lon_start = lon_start; dec.lon_count = lon_count;
+	dec.nranks = nranks;
+	dec.ranks_per_node = std::clamp(ranks_per_node, 1, nranks);
+
+	// summed-area table of the mask, for the weight of each rectangle
+	size_t w = lon_count + 1;
+	std::vector<size_t> sat((lat_count+1)*w, 0);
+	for (size_t i=0; i<lat_count; ++i)
+		for (size_t j=0; j<lon_count; ++j)
+			sat[(i+1)*w + j+1] = (valid.empty() || valid[i*lon_count + j]) + sat[i*w + j+1] + sat[(i+1)*w + j] - sat[i*w + j];
+	auto weight = [&](const TileRect& r){
+		return sat[r.i1*w + r.j1] - sat[r.i0*w + r.j1] - sat[r.i1*w + r.j0] + sat[r.i0*w + r.j0];
+	};
+
+	// nodes (the last one may have fewer ranks)
+	int nnodes = (nranks + dec.ranks_per_node - 1)/dec.ranks_per_node;
+	std::vector<size_t> node_sizes(nnodes);
+	for (int k=0; k<nnodes; ++k) node_sizes[k] = std::min(dec.ranks_per_node, nranks - k*dec.ranks_per_node);
+	std::vector<TileRect> nodes(nnodes);
+	bisect(TileRect{0, lat_count, 0, lon_count}, node_sizes, 0, nnodes, weight, nodes);
+
+	size_t ntiles = std::max(tiles_per_rank, size_t(1));
+	for (int k=0; k<nnodes; ++k){
+		// ranks of the node
+		std::vector<TileRect> ranks(node_sizes[k]);
+		bisect(nodes[k], std::vector<size_t>(node_sizes[k], 1), 0, node_sizes[k], weight, ranks);
+		for (size_t q=0; q<ranks.size(); ++q){
+			// tiles of the rank
+			std::vector<TileRect> rects(ntiles);
+			bisect(ranks[q], std::vector<size_t>(ntiles, 1), 0, ntiles, weight, rects);
+			for (auto& r : rects){
+				// shrink to the valid points
+				if (r.i1 > r.i0 && r.j1 > r.j0 && weight(r) > 0){
+					while (weight(TileRect{r.i0, r.i0+1, r.j0, r.j1}) == 0) ++r.i0;
+					while (weight(TileRect{r.i1-1, r.i1, r.j0, r.j1}) == 0) --r.i1;
+					while (weight(TileRect{r.i0, r.i1, r.j0, r.j0+1}) == 0) ++r.j0;
+					while (weight(TileRect{r.i0, r.i1, r.j1-1, r.j1}) == 0) --r.j1;
+				}
+				Tile t;
+				t.lat_start = lat_start + r.i0; t.lat_count = r.i1 - r.i0;
+				t.lon_start = lon_start + r.j0; t.lon_count = r.j1 - r.j0;
+				t.weight = (t.lat_count && t.lon_count)? weight(r) : 0;
+				t.rank = k*dec.ranks_per_node + int(q);
+				if (t.weight > 0) dec.tiles.push_back(t);
+			}
+		}
+	}
+
+	std::sort(dec.tiles.begin(), dec.tiles.end(), [](const Tile& a, const Tile& b){
+		return std::tie(a.rank, a.lat_start, a.lon_start) < std::tie(b.rank, b.lat_start, b.lon_start);
+	});
+	return dec;
+}
+
+/// @brief   decompose the current lat/lon window of a cube
+template <class T>
+Decomposition decompose(const GeoCube<T>& cube, int nranks, size_t tiles_per_rank = 4, const std::vector<char>& valid = std::vector<char>(), int ranks_per_node = 1){
+	auto& s = cube.getStarts();
+	auto& c = cube.getCounts();
+	return decompose(s[cube.lat_idx], c[cube.lat_idx], s[cube.lon_idx], c[cube.lon_idx], nranks, tiles_per_rank, valid, ranks_per_node);
+}
+
+/// @brief   mask of the current lat/lon window of a cube (lat-major), from its data, which must hold a single
+///          time slice (e.g. a land-sea mask or any forcing variable): a point is valid if any of its values is not missing
+template <class T>
+std::vector<char> valid_mask(const GeoCube<T>& cube){
+	std::vector<size_t> sc = cube.sliceCounts();
+	if (cube.vec.size() != cube.sliceSize()) throw std::runtime_error("valid_mask: cube must hold a single time slice");
+	std::vector<size_t> st(sc.size(), 1);
+	for (int d=int(sc.size())-2; d>=0; --d) st[d] = st[d+1]*sc[d+1];
+
+	size_t nlat = sc[cube.lat_idx], nlon = sc[cube.lon_idx];
+	std::vector<char> mask(nlat*nlon, 0);
+	for (size_t k=0; k<cube.vec.size(); ++k){
+		T v = cube.vec[k];
+		if (v == cube.missing_value || v != v) continue; // (v != v for NaN)
+		mask[((k/st[cube.lat_idx])%nlat)*nlon + (k/st[cube.lon_idx])%nlon] = 1;
+	}
+	return mask;
+}
+
+/// @brief   set the lat/lon window of a cube to a tile
+template <class T>
+void setTile(GeoCube<T>& cube, const Tile& t){
+	cube.setIndexRange(cube.lat_idx, t.lat_start, t.lat_count);
+	cube.setIndexRange(cube.lon_idx, t.lon_start, t.lon_count);
+}
+
+
+/// @brief  copy the sub-array at offset off with shape shape out of a row-major array with shape full
+template <class T>
+void copy_subarray(const T* src, const std::vector<size_t>& full, const std::vector<size_t>& off, const std::vector<size_t>& shape, T* dst){
+	size_t nd = full.size();
+	std::vector<size_t> st(nd, 1);
+	for (int d=int(nd)-2; d>=0; --d) st[d] = st[d+1]*full[d+1];
+	size_t run = shape[nd-1];
+	size_t nruns = std::accumulate(shape.begin(), shape.end()-1, size_t(1), std::multiplies<size_t>());
+	std::vector<size_t> idx(nd, 0);
+	for (size_t r=0; r<nruns; ++r){
+		size_t o = off[nd-1];
+		for (size_t d=0; d+1<nd; ++d) o += (off[d] + idx[d])*st[d];
+		std::copy(src + o, src + o + run, dst + r*run);
+		for (int d=int(nd)-2; d>=0; --d){
+			if (++idx[d] < shape[d]) break;
+			idx[d] = 0;
+		}
+	}
+}
+
+
+// start time of a process (in clock ticks since boot, field 22 of /proc/<pid>/stat), 0 if it does not exist.
+// Together with the pid, it identifies a process: pids are reused, start times are not.
+inline uint64_t process_start_time(pid_t pid){
+	std::ifstream f("/proc/" + std::to_string(pid) + "/stat");
+	std::string stat;
+	if (!std::getline(f, stat)) return 0;
+	size_t p = stat.rfind(')'); // (the command name may contain spaces)
+	if (p == std::string::npos) return 0;
+	std::istringstream ss(stat.substr(p+1));
+	std::string field;
+	for (int i=3; i<=22; ++i) ss >> field; // fields 3 (state) ... 22 (starttime)
+	return ss? std::stoull(field) : 0;
+}
+
+/// @brief  Shape of the slab read by a CollectiveReader: dims in the variable's order, with count 1 along the unlimited dim
+struct SlabLayout {
+	std::vector<size_t> counts;
+	int lat_idx = -1, lon_idx = -1, unlim_idx = -1;
+};
+
+
+/// @brief  Collective reads for the processes (ranks) of one node. One process (local rank 0, the leader) reads
+///         a single slab covering the tiles of all ranks on the node into POSIX shared memory, and every process
+///         copies its own tiles out of it. This replaces many small uncoordinated reads on the shared filesystem
+///         by one large read per node.
+///         All processes of a node must construct the reader with the same name and decomposition, and call
+///         readBlock() collectively. Ranks on a node must be consecutive: the node of rank r holds the ranks
+///         [r - local_rank, r - local_rank + local_size). Only the leader needs to open the file. The shared
+///         memory name must be unique per node (e.g. include the job id); workers ignore a segment of that name
+///         left over from a crashed run, since its leader (pid and start time, stored in the header) is gone.
+template <class T>
+class CollectiveReader {
+	public:
+	/// reads the slab for [unlim_start, unlim_start+unlim_count) into buffer
+	using ReadFn = std::function<void(size_t unlim_start, size_t unlim_count, T* buffer)>;
+
+	std::vector<Tile> tiles;            // tiles of this rank
+	std::vector<std::vector<T>> data;   // data of each tile after readBlock(): the slab layout, restricted to the tile
+
+	private:
+	struct Header {
+		std::atomic<uint64_t> ready;
+		int32_t leader_pid;     // process that created the segment, with its start time: identifies the run, so that
+		uint64_t leader_start;  // workers can tell a segment left over from a crashed run from the current one
+		pthread_barrier_t barrier;
+		int32_t ndims, lat_idx, lon_idx, unlim_idx;
+		uint64_t counts[8];
+		uint64_t unlim_count;   // count along the unlimited dim of the current block
+		uint64_t capacity;      // [elements]
+		int32_t error;
+		char message[256];
+	};
+	static constexpr uint64_t magic = 0x4c42414c53524c46; // "FLRSLABL"
+	static constexpr size_t data_offset = (sizeof(Header) + 63)/64*64;
+
+	std::string shm_name;
+	int local_rank, local_size;
+	Tile node_bounds;      // bounding box of the tiles of the node
+	ReadFn read;
+	SlabLayout layout;
+	Header* h = nullptr;
+	T* slab = nullptr;
+	size_t map_bytes = 0;
+
+	public:
+	/// @param layout           slab shape (leader only)
+	/// @param read             reads the node's slab (leader only)
+	/// @param max_unlim_count  largest unlim_count that will be passed to readBlock() (leader only)
+	CollectiveReader(const std::string& name, int _local_rank, int _local_size, int rank, const Decomposition& dec,
+	                 SlabLayout _layout, ReadFn _read, size_t max_unlim_count = 1)
+		: shm_name(name), local_rank(_local_rank), local_size(_local_size), read(_read), layout(_layout) {
+		if (shm_name.empty() || shm_name[0] != '/') shm_name = "/" + shm_name;
+		tiles = dec.tilesOf(rank);
+		data.resize(tiles.size());
+		node_bounds = dec.bounds(rank - local_rank, local_size);
+
+		if (local_rank == 0) create(max_unlim_count);
+		else attach();
+	}
+
+	/// @brief   collective reader for a GeoCube. The leader restricts its cube to the node's tiles and reads through
+	///          it; the other ranks may pass nullptr.
+	CollectiveReader(const std::string& name, int _local_rank, int _local_size, int rank, const Decomposition& dec,
+	                 GeoCube<T>* cube, size_t max_unlim_count = 1)
+		: CollectiveReader(name, _local_rank, _local_size, rank, dec, leader_layout(_local_rank, _local_size, rank, dec, cube),
+		                   leader_read(_local_rank, cube), max_unlim_count) {}
+
+	~CollectiveReader(){
+		if (h) munmap((void*)h, map_bytes);
+		if (local_rank == 0) shm_unlink(shm_name.c_str());
+	}
+
+	CollectiveReader(const CollectiveReader&) = delete;
+	CollectiveReader& operator=(const CollectiveReader&) = delete;
+
+	/// @brief   collective read of the block [unlim_start, unlim_start+unlim_count) (the arguments of the leader are used).
+	///          Fills data with this rank's tiles.
+	void readBlock(size_t unlim_start, size_t unlim_count){
+		if (local_rank == 0){
+			h->error = 0;
+			try{
+				if (unlim_count*slab_size(1) > h->capacity) throw std::runtime_error("CollectiveReader: block exceeds max_unlim_count");
+				h->unlim_count = unlim_count;
+				if (node_bounds.weight > 0) read(unlim_start, unlim_count, slab);
+			}
+			catch (std::exception& e){
+				h->error = 1;
+				std::strncpy(h->message, e.what(), sizeof(h->message)-1);
+			}
+		}
+		pthread_barrier_wait(&h->barrier); // slab is ready
+		if (h->error) throw std::runtime_error(std::string("CollectiveReader: read failed on the leader: ") + h->message);
+
+		std::vector<size_t> full(h->counts, h->counts + h->ndims);
+		if (h->unlim_idx >= 0) full[h->unlim_idx] = h->unlim_count;
+		for (size_t i=0; i<tiles.size(); ++i){
+			std::vector<size_t> off(full.size(), 0), shape = full;
+			off[h->lat_idx] = tiles[i].lat_start - node_bounds.lat_start;
+			off[h->lon_idx] = tiles[i].lon_start - node_bounds.lon_start;
+			shape[h->lat_idx] = tiles[i].lat_count;
+			shape[h->lon_idx] = tiles[i].lon_count;
+			data[i].resize(std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>()));
+			copy_subarray(slab, full, off, shape, data[i].data());
+		}
+		pthread_barrier_wait(&h->barrier); // all ranks are done with the slab
+	}
+
+	/// @brief   shape of the data of tile i (after readBlock())
+	std::vector<size_t> tileCounts(size_t i) const {
+		std::vector<size_t> shape(h->counts, h->counts + h->ndims);
+		if (h->unlim_idx >= 0) shape[h->unlim_idx] = h->unlim_count;
+		shape[h->lat_idx] = tiles[i].lat_count;
+		shape[h->lon_idx] = tiles[i].lon_count;
+		return shape;
+	}
+
+	/// @brief   bounding box of the tiles of this node (the slab read by the leader)
+	const Tile& nodeBounds() const {
+		return node_bounds;
+	}
+
+	private:
+
+	size_t slab_size(size_t unlim_count) const {
+		size_t n = 1;
+		for (int d=0; d<h->ndims; ++d) n *= (d == h->unlim_idx)? unlim_count : h->counts[d];
+		return n;
+	}
+
+	static SlabLayout leader_layout(int _local_rank, int _local_size, int rank, const Decomposition& dec, GeoCube<T>* cube){
+		SlabLayout l;
+		if (_local_rank != 0) return l;
+		if (!cube) throw std::runtime_error("CollectiveReader: the leader needs a cube to read from");
+		Tile b = dec.bounds(rank, _local_size);
+		if (b.weight > 0) setTile(*cube, b);
+		l.counts = cube->getCounts();
+		l.lat_idx = cube->lat_idx;
+		l.lon_idx = cube->lon_idx;
+		l.unlim_idx = cube->unlim_idx;
+		if (l.unlim_idx >= 0) l.counts[l.unlim_idx] = 1;
+		return l;
+	}
+
+	static ReadFn leader_read(int _local_rank, GeoCube<T>* cube){
+		if (_local_rank != 0) return nullptr;
+		return [cube](size_t unlim_start, size_t unlim_count, T* buffer){ cube->readBlockInto(unlim_start, unlim_count, buffer); };
+	}
+
+	void create(size_t max_unlim_count){
+		if (layout.counts.empty() || layout.counts.size() > 8 || layout.lat_idx < 0 || layout.lon_idx < 0)
+			throw std::runtime_error("CollectiveReader: invalid slab layout");
+		if (node_bounds.weight > 0 && (layout.counts[layout.lat_idx] != node_bounds.lat_count || layout.counts[layout.lon_idx] != node_bounds.lon_count))
+			throw std::runtime_error("CollectiveReader: slab layout does not match the tiles of the node");
+
+		size_t capacity = std::max(max_unlim_count, size_t(1));
+		for (int d=0; d<int(layout.counts.size()); ++d) if (d != layout.unlim_idx) capacity *= layout.counts[d];
+		map_bytes = data_offset + capacity*sizeof(T);
+
+		shm_unlink(shm_name.c_str()); // left over from a crashed run
+		int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd < 0) throw std::runtime_error("CollectiveReader: cannot create shared memory " + shm_name + ": " + std::strerror(errno));
+		if (ftruncate(fd, map_bytes) != 0){
+			close(fd);
+			throw std::runtime_error("CollectiveReader: cannot size shared memory " + shm_name + ": " + std::strerror(errno));
+		}
+		void* p = mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED) throw std::runtime_error("CollectiveReader: cannot map shared memory " + shm_name);
+
+		h = (Header*)p;
+		slab = (T*)((char*)p + data_offset);
+		h->ndims = layout.counts.size();
+		h->lat_idx = layout.lat_idx;
+		h->lon_idx = layout.lon_idx;
+		h->unlim_idx = layout.unlim_idx;
+		for (size_t d=0; d<layout.counts.size(); ++d) h->counts[d] = layout.counts[d];
+		h->unlim_count = 1;
+		h->capacity = capacity;
+		h->error = 0;
+		h->leader_pid = getpid();
+		h->leader_start = process_start_time(getpid());
+
+		pthread_barrierattr_t attr;
+		pthread_barrierattr_init(&attr);
+		pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		pthread_barrier_init(&h->barrier, &attr, local_size);
+		pthread_barrierattr_destroy(&attr);
+
+		h->ready.store(magic, std::memory_order_release);
+	}
+
+	// wait (up to a minute) for the leader to create and initialize the shared memory, then map it.
+	// A segment left over from a crashed run (whose leader no longer exists) is skipped until the leader replaces it.
+	void attach(){
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+		while (true){
+			int fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+			struct stat st;
+			if (fd >= 0 && fstat(fd, &st) == 0 && size_t(st.st_size) >= data_offset){
+				void* p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				close(fd);
+				if (p == MAP_FAILED) throw std::runtime_error("CollectiveReader: cannot map shared memory " + shm_name);
+				Header* hp = (Header*)p;
+				bool initialized = false;
+				while (std::chrono::steady_clock::now() < deadline){
+					if (hp->ready.load(std::memory_order_acquire) == magic){
+						initialized = true;
+						break;
+					}
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				if (!initialized){
+					munmap(p, st.st_size);
+					throw std::runtime_error("CollectiveReader: timed out waiting for the leader");
+				}
+				if (hp->leader_start != 0 && process_start_time(hp->leader_pid) == hp->leader_start){
+					h = hp;
+					map_bytes = st.st_size;
+					slab = (T*)((char*)p + data_offset);
+					return;
+				}
+				munmap(p, st.st_size); // stale segment
+			}
+			else if (fd >= 0) close(fd);
+			if (std::chrono::steady_clock::now() > deadline) throw std::runtime_error("CollectiveReader: timed out waiting for shared memory " + shm_name);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+};
+
+} // namespace flare
+
+#endif
@@ -1 +1,21 @@
-#include "geocube.h"
\ No newline at end of file
+#include "axis_index.h"
+#include "binary_cache.h"
+#include "chunk_reader.h"
+#include "cube_view.h"
+#include "decomposition.h"
+#include "geocube.h"
+#include "geocube_writer.h"
+#include "hyperslab.h"
+#include "instrument.h"
+#include "meta_cache.h"
+#include "mfgeocube.h"
+#include "point_sampling.h"
+#include "prefetcher.h"
+#include "read_plan.h"
+#include "reader_group.h"
+#include "regridder.h"
+#include "slice_cache.h"
+#include "temporal_reducer.h"
+#include "thread_pool.h"
+#include "time_interpolator.h"
+#include "unpack.h"
@@ -1,9 +1,19 @@
 #ifndef FLARE_FLARE_GEOCUBE_H
 #define FLARE_FLARE_GEOCUBE_H
 
+#include <numeric>
+#include <functional>
+#include <memory>
 #include <tensor.h>
 #include "ncfilepp.h"
 #include "time_math.h"
+#include "slice_cache.h"
+#include "unpack.h"
+#include "axis_index.h"
+#include "point_sampling.h"
+#include "read_plan.h"
+#include "hyperslab.h"
+#include "chunk_reader.h"
 
 namespace flare{
 
@@ -15,8 +25,13 @@ class GeoCube : public Tensor<T> {
 	std::vector <std::string> dimnames;
 	int unlim_idx = -1;
 	float scale_factor = 1.0, add_offset = 0.0; 
-	std::vector<std::vector<double>> coords;
-	std::vector<std::vector<double>> coords_trimmed;
+	bool unpack_on_read = false; // if true, apply scale_factor/add_offset and replace missing values by NaN after reading (floating point T only)
+	StorageLayout storage;       // chunking and compression of the variable in the file
+	size_t max_read_bytes = 0;   // if > 0, block reads larger than this are split into chunk-aligned sub-reads
+	bool verbose = false;        // if true, log changes of the data tensor's shape
+	bool lon_periodic = false;   // whether the longitude axis covers the full circle (detected in readMeta), so that lon ranges can wrap around
+	std::vector<CoordArray> coords;          // full coordinate axes (shared with the file's metadata; see CoordArray::mut() to modify)
+	std::vector<CoordArray> coords_trimmed;  // coordinates of the current window (shared with coords where not trimmed)
 
 	int lon_idx, lat_idx, t_idx;
 
@@ -26,7 +41,7 @@ class GeoCube : public Tensor<T> {
 	std::vector<std::string> lat_names_try = {"lat", "latitude", "y"};
 	std::vector<std::string> lon_names_try = {"lon", "longitude", "x"};
 
-	private:
+	protected:
 	netCDF::NcVar ncvar;
 	std::vector <size_t> dimsizes;
 	std::vector <std::string> dimunits;
@@ -40,15 +55,50 @@ class GeoCube : public Tensor<T> {
 	double tstep;           // interval between data frames [days] 
 	double tscale = 1;      // multiplier to convert time from file's unit to 'days'
 	std::tm t_base = {};    // epoch used in file
+	double julian_base = 0; // julian day of t_base
+	Calendar calendar = Calendar::gregorian; // calendar of the time axis
+	double calendar_base = 0;                // t_base in days since the calendar's epoch
+
+	std::vector<AxisIndex> coords_index;   // fast index lookups on coords
+	std::vector<AxisIndex> trimmed_index;  // fast index lookups on coords_trimmed
+
+	SliceCache<T>* cache = nullptr; // optional cache for time slices (not owned)
+
+	std::string file_path;                       // file the variable was read from (if opened via NcFilePP::open)
+	bool file_staged = false;                    // whether that file is served from memory (see NcFilePP::Staging)
+	bool in_root_group = false;                  // whether the variable is in the root group of the file
+	std::string cache_source;                    // data source in SliceCache keys (file path and modification time)
+	std::string io_label;                        // label of this variable's reads in the I/O instrumentation (file path:name)
+	std::shared_ptr<ChunkReader> chunk_reader;   // parallel chunk decompression (see setDecompressionPool)
+	ThreadPool* decompression_pool = nullptr;    // (not owned)
+
+	std::vector<size_t> tensor_shape;   // shape the data tensor was last resized to (see reshape())
+
+	netCDF::NcType::ncType packed_type; // type of the variable in the file
+	double fill_value = 0;              // missing value in file units (before unpacking)
+	bool has_fill = false;
 
 	public:
+	virtual ~GeoCube() = default;
+
 	void readMeta(NcFilePP &in_file, std::string varname = ""){
 		// get the named variable, or the first variable in the file
 		if (varname != "") ncvar = in_file.vars_map.find(varname)->second;
 		else ncvar = in_file.vars_map.begin()->second;
 
+		// (metadata queries are netCDF calls too: serialize them with reads from other threads)
+		std::lock_guard<std::mutex> lock(netcdf_mutex(root_ncid(in_file.getId())));
+
 		// get variable name and dimensions
 		name = ncvar.getName();
+		file_path = in_file.path;
+		// (variables of the same name in different files are counted separately)
+		io_label = file_path.empty()? name : file_path + ":" + name;
+		FLARE_INSTRUMENT_SCOPE("GeoCube::readMeta", io_label);
+		file_staged = in_file.staged();
+		// (ncids are reused after files are closed, so cache keys are based on the file itself)
+		cache_source = file_path.empty()? "ncid:" + std::to_string(in_file.getId()) : file_path + "@" + std::to_string(FileStamp::of(file_path).mtime_ns);
+		in_root_group = (ncvar.getParentGroup().getId() == in_file.getId());
 		std::vector <netCDF::NcDim> ncdims = ncvar.getDims();
 
 		// get names and sizes of dimensions for this variable
@@ -57,7 +107,7 @@ class GeoCube : public Tensor<T> {
 			dimsizes.push_back(d.getSize());
 		}
 
-		// copy the coordinate vectors that were read during file reading
+		// share the coordinate vectors that were read during file reading
 		for (auto s : dimnames){
 			coords.push_back(in_file.coordvalues_map.at(s));
 		}
@@ -85,6 +135,14 @@ class GeoCube : public Tensor<T> {
 		lat_idx = std::find(dimnames.begin(), dimnames.end(), "lat") - dimnames.begin();
 		if (lon_idx >= dimsizes.size() || lat_idx >= dimsizes.size()) throw std::runtime_error("Lat or Lon not found"); 
 		
+		// longitude is periodic if n steps of the grid spacing span 360 degrees
+		{
+			auto& x = coords[lon_idx];
+			size_t n = x.size();
+			double dx = (n > 1)? std::fabs(x[n-1] - x[0])/(n-1) : 0;
+			lon_periodic = (n > 1) && std::fabs(dx*n - 360) < 0.01*dx;
+		}
+
 		// get unlimited dimension id
 		for (int i=0; i<ncdims.size(); ++i) if (ncdims[i].isUnlimited()) unlim_idx = i;
 	
@@ -102,6 +160,17 @@ class GeoCube : public Tensor<T> {
 			catch(netCDF::exceptions::NcException &e){ std::cout << "Missing/Fill value not found. Setting to NaN\n";}
 		}
 
+		// missing value and type as stored in the file, needed for unpacking
+		has_fill = false;
+		for (std::string att : {"missing_value", "_FillValue"}){
+			try{ ncvar.getAtt(att).getValues(&fill_value); has_fill = true; break;}
+			catch(netCDF::exceptions::NcException &e){}
+		}
+		packed_type = ncvar.getType().getTypeClass();
+
+		// storage layout
+		readStorageLayout();
+
 		// unit
 		try{ ncvar.getAtt("units").getValues(unit); }
 		catch(netCDF::exceptions::NcException &e){ std::cout << "Warning: Variable does not have a unit\n";}
@@ -124,6 +193,8 @@ class GeoCube : public Tensor<T> {
 			t_idx = -1;
 			std::cout << "Warning: Variable does not have a time dimension\n";
 		}
+
+		build_axis_indices();
 	}
 
 
@@ -139,8 +210,11 @@ class GeoCube : public Tensor<T> {
 		std::cout << "   missing value = " << this->missing_value << "\n";
 		std::cout << "   scale factor = " << scale_factor << "\n";
 		std::cout << "   add offset = " << add_offset << "\n";
+		std::cout << "   unpack on read = " << (unpack_on_read? "yes" : "no") << "\n";
+		storage.print("   ");
 		std::cout << "   tbase = " << std::put_time(&t_base, "%Y-%m-%d %H:%M:%S %Z") << "\n";
 		std::cout << "   tscale = " << tscale << " (" << tunit << ")\n";
+		std::cout << "   calendar = " << calendar_name(calendar) << "\n";
 		std::cout << "   tstep = " << tstep << " days" << "\n";
 		std::cout << "   dimensions:\n";
 		for (int i=0; i<dimnames.size(); ++i){
@@ -156,22 +230,20 @@ class GeoCube : public Tensor<T> {
 	}
 
 	
+	/// @brief            restrict an axis to the coordinate range [lo, hi] (from the last value before lo to the first value beyond hi).
+	///                   On a periodic longitude axis, the range may cross the edge of the grid (see setLonBounds).
 	void setCoordBounds(size_t axis, float lo, float hi){
-		double descending = *coords[axis].rbegin() < *coords[axis].begin(); // check if the coordinate values are descending
-		// get the start and end coordinate values that are just outside the lo-hi range
-		size_t start=0, end=0;
-		if (!descending){
-			for (int i=0; i< coords[axis].size(); ++i) if (coords[axis][i] < lo) start = i; 
-			for (int i=coords[axis].size()-1; i>=0; --i) if (coords[axis][i] > hi) end = i; 
-		}
-		else{
-			for (int i=0; i< coords[axis].size(); ++i) if (coords[axis][i] > hi) start = i; 
-			for (int i=coords[axis].size()-1; i>=0; --i) if (coords[axis][i] < lo) end = i; 
+		if (int(axis) == lon_idx){
+			setLonBounds(lo, hi);
+			return;
 		}
+		size_t start, end;
+		coord_range(axis, lo, hi, start, end);
 		starts[axis] = start;
 		counts[axis] = end - start + 1;
 
 		coords_trimmed[axis].assign(coords[axis].begin()+start, coords[axis].begin()+end+1);
+		trimmed_index[axis] = AxisIndex(coords_trimmed[axis]);
 
 		// std::cout << "axis = " << dimnames[axis] << '\n';
 		// std::cout << "Start: " << start << " " << coords[axis][start] << '\n';
@@ -180,30 +252,248 @@ class GeoCube : public Tensor<T> {
 		// else std::cout << ">>> " << coords[axis][start] << " | " << hi <<  " " << lo << " | " << coords[axis][end] << "\n";
 	}
 
+	/// @brief            restrict longitude to the range [lo, hi], with the bracketing of setCoordBounds, plus halo ghost
+	///                   columns on each side. If the longitude axis is periodic, the range wraps around the edge of the grid:
+	///                   lo > hi crosses the dateline eastward (e.g. 170 to -170 is the 20 degrees around 180), bounds may be
+	///                   given in either convention (e.g. -180 to 180 on a 0-360 grid), and a range of 360 degrees or more is
+	///                   the full globe starting at lo. Wrapped ranges are read as one piece per period into one contiguous block,
+	///                   and coords_trimmed holds monotonic longitudes in the frame of lo (e.g. 169.75 ... 190.25).
+	///                   Bounds within half a grid step of the edge do not wrap (0 to 180 on a -179.75 ... 179.75 grid ends at 179.75).
+	///                   On a non-periodic axis, the range and halo are clipped to the grid.
+	void setLonBounds(double lo, double hi, size_t halo = 0){
+		size_t start, count;
+		lon_range(lo, hi, halo, start, count);
+		starts[lon_idx] = start;
+		counts[lon_idx] = count;
+
+		std::vector<double> x(count);
+		for (size_t i=0; i<count; ++i) x[i] = lon_coord(start + i);
+		if (lon_periodic){
+			// shift to the frame of the requested range
+			double shift = 360*std::round((lo - x[std::min(halo, count-1)])/360);
+			for (auto& v : x) v += shift;
+		}
+		coords_trimmed[lon_idx] = std::move(x);
+		trimmed_index[lon_idx] = AxisIndex(coords_trimmed[lon_idx]);
+	}
+
 	void setIndices(size_t axis, size_t _start, size_t _count, ptrdiff_t _stride = 1){
 		starts[axis]  = _start;
 		counts[axis]  = _count;
 		strides[axis] = _stride;
 	}
 
-	void readBlock(size_t unlim_start, size_t unlim_count){
+	/// @brief            restrict an axis to the index range [_start, _start+_count) of the full axis, 
+	///                   and trim its coordinates accordingly
+	void setIndexRange(size_t axis, size_t _start, size_t _count){
+		if (_count == 0 || _start + _count > coords[axis].size()) throw std::runtime_error("setIndexRange: range out of bounds on axis " + dimnames[axis]);
+		setIndices(axis, _start, _count);
+		coords_trimmed[axis].assign(coords[axis].begin()+_start, coords[axis].begin()+_start+_count);
+		trimmed_index[axis] = AxisIndex(coords_trimmed[axis]);
+	}
+
+	/// @brief            current hyperslab (as set by setCoordBounds/setIndices)
+	Hyperslab hyperslab() const {
+		return Hyperslab{starts, counts, strides};
+	}
+
+	/// @brief            query: h restricted to the coordinate range [lo, hi] along an axis, with the same
+	///                   bracketing as setCoordBounds. The cube is not modified.
+	Hyperslab withCoordBounds(Hyperslab h, size_t axis, double lo, double hi) const {
+		if (int(axis) == lon_idx) return withLonBounds(h, lo, hi);
+		size_t start, end;
+		coord_range(axis, lo, hi, start, end);
+		h.starts[axis] = start;
+		h.counts[axis] = end - start + 1;
+		h.strides[axis] = 1;
+		return h;
+	}
+
+	/// @brief            query: h restricted to the longitude range [lo, hi] plus halo ghost columns, wrapping
+	///                   around a periodic axis as in setLonBounds. The cube is not modified.
+	Hyperslab withLonBounds(Hyperslab h, double lo, double hi, size_t halo = 0) const {
+		size_t start, count;
+		lon_range(lo, hi, halo, start, count);
+		return withIndices(h, lon_idx, start, count);
+	}
+
+	/// @brief            query: h with the index range [_start, _start+_count) along an axis
+	Hyperslab withIndices(Hyperslab h, size_t axis, size_t _start, size_t _count, ptrdiff_t _stride = 1) const {
+		h.starts[axis] = _start;
+		h.counts[axis] = _count;
+		h.strides[axis] = _stride;
+		return h;
+	}
+
+	/// @brief            query: h at the time slice for julian_day (see julian_to_index)
+	Hyperslab atTime(Hyperslab h, double julian_day, bool periodic, bool centred_t) const {
+		if (t_idx < 0) return h;
+		return withIndices(h, t_idx, julian_to_index(julian_day, periodic, centred_t), 1);
+	}
+
+	/// @brief            coordinate values of a hyperslab along an axis (time in days since the time base)
+	std::vector<double> coordValues(const Hyperslab& h, size_t axis) const {
+		auto& x = (int(axis) == t_idx)? coords_trimmed[axis] : coords[axis]; // (time indices refer to the converted time axis)
+		std::vector<double> v(h.counts[axis]);
+		if (int(axis) == lon_idx && lon_periodic){ // (may wrap around)
+			for (size_t i=0; i<v.size(); ++i) v[i] = lon_coord(h.starts[axis] + i*h.strides[axis]);
+			return v;
+		}
+		for (size_t i=0; i<v.size(); ++i) v[i] = x.at(h.starts[axis] + i*h.strides[axis]);
+		return v;
+	}
+
+	/// @brief            read a hyperslab into buffer (which must hold h.size() elements).
+	///                   The cube is not modified, so any number of threads can read different hyperslabs
+	///                   from one cube concurrently. netCDF calls are serialized through netcdf_mutex() 
+	///                   (per file with FLARE_NETCDF_THREADSAFE); unpacking and the other work around them
+	///                   run in parallel. Slice caches attached with setCache() are not used.
+	virtual void read(const Hyperslab& h, T* buffer) const {
+		if (h.starts.size() != dimnames.size() || h.counts.size() != dimnames.size() || h.strides.size() != dimnames.size())
+			throw std::runtime_error("read: hyperslab has the wrong number of dimensions");
+		read_block(h.starts, h.counts, h.strides, buffer);
+	}
+
+	void read(const Hyperslab& h, std::vector<T>& buffer) const {
+		buffer.resize(h.size());
+		read(h, buffer.data());
+	}
+
+	/// @brief            start indices of the current hyperslab
+	const std::vector<size_t>& getStarts() const {
+		return starts;
+	}
+
+	/// @brief            counts of the current hyperslab
+	const std::vector<size_t>& getCounts() const {
+		return counts;
+	}
+
+	/// @brief            strides of the current hyperslab
+	const std::vector<ptrdiff_t>& getStrides() const {
+		return strides;
+	}
+
+	virtual void readBlock(size_t unlim_start, size_t unlim_count){
 		if (unlim_idx >= 0){
 			starts[unlim_idx] = unlim_start;
 			counts[unlim_idx] = unlim_count;
 		}
-		std::cout << "Resizing tensor to: " << counts;
-		this->resize(counts);
-		ncvar.getVar(starts, counts, strides, this->vec.data());
+		reshape(counts);
+		read_block(starts, counts, strides, this->vec.data());
+		if (unpack_on_read) set_unpacked_missing_value();
+	}
+
+	/// @brief              read a block along the unlimited dimension (with the current window along the
+	///                     other dimensions) into an external buffer. The cube is not modified.
+	/// @param buffer       destination, must hold at least sliceSize()*unlim_count elements (if the unlimited dim is time)
+	virtual void readBlockInto(size_t unlim_start, size_t unlim_count, T* buffer) const {
+		thread_local std::vector<size_t> s, c;
+		s = starts;
+		c = counts;
+		if (unlim_idx >= 0){
+			s[unlim_idx] = unlim_start;
+			c[unlim_idx] = unlim_count;
+		}
+		read_block(s, c, strides, buffer);
+	}
+
+	/// @brief   plan for reading the current hyperslab: chunk-aligned sub-reads (see max_read_bytes), 
+	///          and bytes decompressed vs delivered
+	ReadPlan readPlan() const {
+		return make_read_plan(storage, starts, counts, strides, sizeof(T), max_read_bytes);
 	}
 
-	void readBlock(double julian_day, bool periodic, bool centred_t){
-		if (t_idx > 0){
+	/// @brief   size the chunk cache of this variable for the current spatial window and the given access pattern.
+	///          For time_slice access, the cache holds all chunks touched by one time slice, so that successive 
+	///          slices that fall in the same chunks do not decompress them again. For time_series access, each chunk 
+	///          is read once, so fully read chunks are evicted first.
+	void setAccessPattern(AccessPattern pattern){
+		if (!storage.chunked) return;
+		std::vector<size_t> c = sliceCounts();
+		size_t n = 1;
+		for (auto nd : chunks_touched(storage, starts, c, strides)) n *= nd;
+
+		size_t size = size_t(1.1*n*storage.chunk_bytes()) + 1024*1024;
+		size_t nelems = next_prime(std::max(size_t(1009), 10*n));
+		float preemption = (pattern == AccessPattern::time_series)? 1.0f : 0.75f;
+
+		std::lock_guard<std::mutex> lock(netcdf_mutex(root_ncid(ncvar.getParentGroup().getId())));
+		int status = nc_set_var_chunk_cache(ncvar.getParentGroup().getId(), ncvar.getId(), size, nelems, preemption);
+		if (status != NC_NOERR) throw std::runtime_error("setAccessPattern: could not set chunk cache: " + std::string(nc_strerror(status)));
+	}
+
+	virtual void readBlock(double julian_day, bool periodic, bool centred_t){
+		if (t_idx >= 0){
 			starts[t_idx] = julian_to_index(julian_day, periodic, centred_t);
 			counts[t_idx] = 1;
 		}
-		std::cout << "Resizing tensor to: " << counts;
-		this->resize(counts);
-		ncvar.getVar(starts, counts, strides, this->vec.data());
+		reshape(counts);
+		read_slice(ncvar, starts, counts, this->vec.data());
+		if (unpack_on_read) set_unpacked_missing_value();
+	}
+
+	/// @brief   dimensions of a single time slice with the current spatial window
+	std::vector<size_t> sliceCounts() const {
+		std::vector<size_t> c = counts;
+		if (t_idx >= 0) c[t_idx] = 1;
+		return c;
+	}
+
+	/// @brief   number of elements in a single time slice with the current spatial window
+	size_t sliceSize() const {
+		size_t n = 1;
+		for (int d=0; d<int(counts.size()); ++d) if (d != t_idx) n *= counts[d];
+		return n;
+	}
+
+	/// @brief          read the slice at time index t_index into an external buffer. 
+	///                 The cube (tensor data and hyperslab) is not modified, 
+	///                 so this can be called from a background thread.
+	/// @param t_index  index along the time axis
+	/// @param buffer   destination, must hold at least sliceSize() elements
+	virtual void readSliceInto(size_t t_index, T* buffer) const {
+		thread_local std::vector<size_t> s, c; // (reused, so that steady-state reads do not allocate)
+		s = starts;
+		c = counts;
+		if (t_idx >= 0){
+			s[t_idx] = t_index;
+			c[t_idx] = 1;
+		}
+		read_slice(ncvar, s, c, buffer);
+	}
+
+	/// @brief          attach a slice cache. Single time-slice reads will be served from the cache when possible.
+	///                 The cache may be shared among several cubes. Pass nullptr to detach.
+	void setCache(SliceCache<T>* _cache){
+		cache = _cache;
+	}
+
+	/// @brief          decompress chunks in parallel on pool when reading this variable, bypassing the serial
+	///                 filter pipeline of netCDF/HDF5 (see ChunkReader). Pass nullptr to switch back to getVar.
+	///                 Must not be used if reads are themselves run as tasks on the same pool.
+	/// @return         whether the parallel path is active. It is not (and reads use getVar) if the build has no
+	///                 HDF5 support, or the variable is not chunked, uses other filters than deflate/shuffle,
+	///                 or is not in the root group of a file opened from disk via NcFilePP::open.
+	bool setDecompressionPool(ThreadPool* pool){
+		chunk_reader.reset();
+		decompression_pool = pool;
+		if (!pool || !storage.chunked || !in_root_group || file_path.empty() || file_staged) return false;
+		auto reader = std::make_shared<ChunkReader>(file_path, "/" + ncvar.getName(), ncvar.getParentGroup().getId());
+		if (reader->ok()) chunk_reader = reader;
+		return bool(chunk_reader);
+	}
+
+	/// @brief          key identifying a hyperslab of this variable in a SliceCache. Indices are those of this cube
+	///                 (e.g. on the joined time axis of an MFGeoCube); the source is identified by file path and
+	///                 modification time, not by netCDF ids, which are reused when files are closed and reopened.
+	std::string cacheKey(const std::vector<size_t>& _starts, const std::vector<size_t>& _counts) const {
+		std::string key = name + "@" + cache_source;
+		for (size_t i=0; i<_starts.size(); ++i){
+			key += "|" + std::to_string(_starts[i]) + "," + std::to_string(_counts[i]) + "," + std::to_string(strides[i]);
+		}
+		if (unpack_on_read) key += "|unpacked";
+		return key;
 	}
 
 
@@ -212,13 +502,13 @@ class GeoCube : public Tensor<T> {
 	/// @param periodic   whether data should be extended periodically
 	/// @param centred_t  whether t at index represents centre of interval (or start of interval)
 	/// @return           index in time vector for which data should be read
-	size_t julian_to_index(double j, bool periodic, bool centred_t){
+	size_t julian_to_index(double j, bool periodic, bool centred_t) const {
 		if (t_idx < 0) throw std::runtime_error("julian_to_index: no time vector in file");
 
 		auto& tvec = coords_trimmed[t_idx];
 
-		// convert desired time to file unit (days since tbase)
-		double t = j - date_to_julian(t_base); 
+		// convert desired time to file unit (days since tbase, in the file's calendar)
+		double t = julian_to_t(j);
 
 		if (centred_t) t += tstep/2;     //   |----0----|-----1----|----2----|---
                                                //   x--->0    |     1    | shift t (x) by half the interval size
@@ -230,9 +520,9 @@ class GeoCube : public Tensor<T> {
 		double DeltaT = tvec[tvec.size()-1] - tvec[0] + tstep;
 		if (periodic) t = tvec[0] + utils::positive_fmod(t - tvec[0], DeltaT);
 
-		// calculate index such that tvec[idx] is just less than t
-		auto t_it = std::lower_bound(tvec.begin(), tvec.end(), t);
-		int idx = t_it - tvec.begin() - 1;
+		// calculate index such that tvec[idx] is just less than t 
+		// (O(1) if the time axis is evenly spaced, binary search otherwise)
+		int idx = int(trimmed_index[t_idx].count_before(tvec, t)) - 1;
 
 		// clamp the start and end points. this case will arise only when periodic is false. 
 		idx = std::clamp(idx, 0, int(tvec.size()-1)); 
@@ -241,33 +531,403 @@ class GeoCube : public Tensor<T> {
 	}
 
 
+	/// @brief            index of the coordinate value nearest to v along an axis (in the full, untrimmed axis)
+	size_t coord_to_index(size_t axis, double v) const {
+		return coords_index[axis].nearest(coords[axis], v);
+	}
+
+	/// @brief                 read time series at a set of points (e.g. flux tower sites). Points are 
+	///                        grouped by storage chunk, so that each chunk is read only once.
+	/// @param lats, lons      coordinates of the points
+	/// @param t_start         first time index to read
+	/// @param t_count         number of time indices to read
+	/// @param method          nearest neighbour or bilinear sampling. Missing neighbours are excluded from the bilinear weights.
+	///                        On a periodic lon axis, points near the edge of the grid are sampled across it.
+	/// @param max_tile        max tile size along lat and lon (limits memory for large chunks or contiguous data)
+	/// @return                Tensor of dims {npoints, t_count}
+	Tensor<T> readPoints(const std::vector<double>& lats, const std::vector<double>& lons, size_t t_start, size_t t_count,
+	                     Sampling method = Sampling::nearest, size_t max_tile = 64) const {
+		if (lats.size() != lons.size()) throw std::runtime_error("readPoints: lats and lons must have the same size");
+		if (t_idx < 0){ t_start = 0; t_count = 1; }
+
+		std::vector<PointStencil> stencils;
+		for (size_t i=0; i<lats.size(); ++i){
+			stencils.push_back(make_stencil(lats[i], lons[i], coords[lat_idx], coords_index[lat_idx], coords[lon_idx], coords_index[lon_idx], method, lon_periodic));
+		}
+
+		// tiles are aligned to the storage chunks
+		size_t tile_lat = max_tile, tile_lon = max_tile;
+		if (storage.chunked){
+			tile_lat = std::min(storage.chunks[lat_idx], max_tile);
+			tile_lon = std::min(storage.chunks[lon_idx], max_tile);
+		}
+		PointReadPlan plan(stencils, tile_lat, tile_lon);
+
+		// read each tile once, and gather the time series of the cells needed from it
+		size_t nd = dimnames.size();
+		std::vector<T> series(plan.cells.size()*t_count);
+		std::vector<T> buf;
+		for (auto& tile : plan.tiles){
+			std::vector<size_t> s = starts, c(nd, 1);
+			s[lat_idx] = tile.lat0; c[lat_idx] = tile.nlat;
+			s[lon_idx] = tile.lon0; c[lon_idx] = tile.nlon;
+			if (t_idx >= 0){ s[t_idx] = t_start; c[t_idx] = t_count; }
+
+			std::vector<size_t> str(nd, 1); // row-major strides of buf
+			for (int k=int(nd)-2; k>=0; --k) str[k] = str[k+1]*c[k+1];
+			buf.resize(str[0]*c[0]);
+			{
+				std::lock_guard<std::mutex> lock(netcdf_mutex(root_ncid(ncvar.getParentGroup().getId())));
+				FLARE_INSTRUMENT_SCOPE("getVar", io_label, buf.size()*sizeof(T), &c);
+				ncvar.getVar(s, c, buf.data());
+			}
+			unpack_buffer(buf.data(), buf.size());
+
+			size_t tstr = (t_idx >= 0)? str[t_idx] : 0;
+			for (size_t id : tile.cells){
+				size_t base = (plan.cells[id].first - tile.lat0)*str[lat_idx] + (plan.cells[id].second - tile.lon0)*str[lon_idx];
+				for (size_t k=0; k<t_count; ++k) series[id*t_count + k] = buf[base + k*tstr];
+			}
+		}
+
+		// combine cells into point values
+		T mv = this->missing_value;
+		if constexpr (std::is_floating_point<T>::value){
+			if (unpack_on_read) mv = std::numeric_limits<T>::quiet_NaN();
+		}
+		Tensor<T> out;
+		out.resize(std::vector<size_t>{lats.size(), t_count});
+		out.missing_value = mv;
+		for (size_t p=0; p<stencils.size(); ++p){
+			for (size_t k=0; k<t_count; ++k){
+				double sum = 0, wsum = 0;
+				for (int j=0; j<stencils[p].n; ++j){
+					T v = series[plan.point_cells[p][j]*t_count + k];
+					if (v == mv || v != v) continue; // skip missing (and NaN) values
+					sum  += stencils[p].w[j]*v;
+					wsum += stencils[p].w[j];
+				}
+				out.vec[p*t_count + k] = (wsum > 0)? T(sum/wsum) : mv;
+			}
+		}
+		return out;
+	}
+
+	/// @brief            julian day of the i-th element of the (trimmed) time axis
+	double t_index_to_julian(size_t i) const {
+		return t_to_julian(coords_trimmed[t_idx][i]);
+	}
+
+	/// @brief            time in file units (days since the time base, in the file's calendar) of julian day j
+	double julian_to_t(double j) const {
+		return julian_to_days_since(calendar, j, julian_base, calendar_base);
+	}
+
+	/// @brief            julian day of time t in file units
+	double t_to_julian(double t) const {
+		return days_since_to_julian(calendar, t, julian_base, calendar_base);
+	}
+
 	std::string t_index_to_datestring(int i){
-		double j = coords_trimmed[t_idx][i] + date_to_julian(t_base);
-		return julian_to_datestring(j);
+		return julian_to_datestring(t_index_to_julian(i));
 	}
 
-	private:
+	/// @brief            I/O counters of this variable in this file (reads through getVar), if instrumentation is enabled
+	instrument::Counters ioStats() const {
+		auto s = instrument::snapshot();
+		return s["getVar"][io_label];
+	}
 
-	void parse_time_unit(NcFilePP &in_file){
-		// parse time units
+	/// @brief            interval between data frames [days]
+	double getTstep() const {
+		return tstep;
+	}
+
+	/// @brief            julian day of the time base (time values are in days since this)
+	double getJulianBase() const {
+		return julian_base;
+	}
+
+	/// @brief            calendar of the time axis (from the calendar attribute of the time variable)
+	Calendar getCalendar() const {
+		return calendar;
+	}
+
+	/// @brief            time base in days since the epoch of the calendar
+	double getCalendarBase() const {
+		return calendar_base;
+	}
+
+	protected:
+
+	void readStorageLayout(){
+		storage = StorageLayout();
+		storage.elem_size = ncvar.getType().getSize();
+		try{
+			netCDF::NcVar::ChunkMode mode;
+			ncvar.getChunkingParameters(mode, storage.chunks);
+			storage.chunked = (mode == netCDF::NcVar::nc_CHUNKED && storage.chunks.size() == dimnames.size());
+			if (!storage.chunked) storage.chunks.clear();
+
+			ncvar.getCompressionParameters(storage.shuffle, storage.deflate, storage.deflate_level);
+
+			auto endian = ncvar.getEndianness();
+			if      (endian == netCDF::NcVar::nc_ENDIAN_LITTLE) storage.endianness = "little";
+			else if (endian == netCDF::NcVar::nc_ENDIAN_BIG)    storage.endianness = "big";
+		}
+		catch(netCDF::exceptions::NcException &e){} // classic format files: contiguous, uncompressed
+	}
+
+	// index range [start, end] on the full axis that brackets the coordinate range [lo, hi]:
+	// start is the last element before lo (or before hi, if descending), 
+	// end is the first element beyond hi (or beyond lo, if descending)
+	void coord_range(size_t axis, double lo, double hi, size_t& start, size_t& end) const {
+		auto& x = coords[axis];
+		bool descending = x.back() < x.front(); // check if the coordinate values are descending
+		const AxisIndex& ax = (axis < coords_index.size())? coords_index[axis] : AxisIndex();
+		long first = long(ax.count_before(x, descending? hi : lo)) - 1;
+		start = std::max(first, 0L);
+		end = std::min(ax.count_before_eq(x, descending? lo : hi), x.size()-1);
+	}
+
+	// index range of the longitude range [lo, hi] plus halo columns on each side (see setLonBounds).
+	// start is in [0, n); on a periodic axis, start + count may exceed n (the range wraps around).
+	void lon_range(double lo, double hi, size_t halo, size_t& start, size_t& count) const {
+		auto& x = coords[lon_idx];
+		long n = x.size();
+		if (lon_periodic && x.back() > x.front()){
+			// bounds within half a grid step outside the grid (e.g. -180 and 180 on a -179.75 ... 179.75 grid)
+			// select the edge column, as on a non-periodic axis, rather than crossing the edge
+			double half = 0.5*(x[1] - x[0]);
+			if (lo < x.front() && lo >= x.front() - half) lo = x.front();
+			if (hi > x.back() && hi <= x.back() + half) hi = x.back();
+		}
+		bool wrap = lon_periodic && x.back() > x.front() && (hi < lo || lo < x.front() || hi > x.back());
+		long first, last; // on the unrolled axis (index i is x[i mod n] shifted by whole periods)
+		if (!wrap){
+			size_t s, e;
+			coord_range(lon_idx, lo, hi, s, e);
+			first = s;
+			last = e;
+		}
+		else {
+			const AxisIndex& ax = coords_index[lon_idx];
+			double width = (hi >= lo)? hi - lo : hi - lo + 360;
+			double lo1 = x.front() + std::fmod(std::fmod(lo - x.front(), 360) + 360, 360);  // lo in [x0, x0+360)
+			if (width >= 360){
+				first = ax.count_before(x, lo1);
+				last = first + n - 1;
+			}
+			else {
+				double hi1 = lo1 + width;
+				long k = long(std::floor((hi1 - x.front())/360));
+				first = long(ax.count_before(x, lo1)) - 1;
+				last = std::min(k*n + long(ax.count_before_eq(x, hi1 - 360*k)), first + n - 1);
+			}
+		}
+		first -= long(halo);
+		last += long(halo);
+		if (!lon_periodic){
+			first = std::max(first, 0L);
+			last = std::min(last, n-1);
+		}
+		start = ((first % n) + n) % n;
+		count = last - first + 1;
+	}
+
+	// longitude at index i of the unrolled (periodic) axis
+	double lon_coord(size_t i) const {
+		auto& x = coords[lon_idx];
+		size_t n = x.size();
+		double period = (x.back() > x.front())? 360 : -360;
+		return x[i % n] + period*double(i / n);
+	}
+
+	// whether a hyperslab wraps around the (periodic) longitude axis
+	bool lon_wraps(const std::vector<size_t>& _starts, const std::vector<size_t>& _counts) const {
+		return lon_idx >= 0 && lon_idx < int(_starts.size()) && _starts[lon_idx] + _counts[lon_idx] > dimsizes[lon_idx];
+	}
+
+	// call f(start, count, offset) for each piece of the index range [start, start+count) on the longitude axis
+	// that lies within one period, where offset is the position of the piece in the range
+	template <class F>
+	void for_each_lon_piece(size_t start, size_t count, F f) const {
+		size_t n = dimsizes[lon_idx];
+		for (size_t off = 0; off < count; start = 0){
+			size_t k = std::min(n - start, count - off);
+			f(start, k, off);
+			off += k;
+		}
+	}
+
+	// (re)build the index lookups for all axes
+	void build_axis_indices(){
+		coords_index.clear();
+		trimmed_index.clear();
+		for (auto& x : coords) coords_index.push_back(AxisIndex(x));
+		for (auto& x : coords_trimmed) trimmed_index.push_back(AxisIndex(x));
+	}
+
+	// read a single slice from var, via the cache if one is attached.
+	// key_starts are the starts in this cube's indices (if they differ from the file's, as in MFGeoCube)
+	void read_slice(const netCDF::NcVar& var, const std::vector<size_t>& _starts, const std::vector<size_t>& _counts, T* buffer, const std::vector<size_t>* key_starts = nullptr) const {
+		size_t n = std::accumulate(_counts.begin(), _counts.end(), size_t(1), std::multiplies<size_t>());
+		std::string key;
+		if (cache){
+			key = cacheKey(key_starts? *key_starts : _starts, _counts);
+			if (cache->get(key, buffer, n)) return;
+		}
+		read_hyperslab(var, _starts, _counts, strides, buffer);
+		if (cache) cache->put(key, buffer, n);
+	}
+
+	// read a hyperslab from var into buffer, unpacking if requested. 
+	// Packed short/byte data is read in its native type and converted, scaled and 
+	// masked in a single (vectorized) pass.
+	void read_hyperslab(const netCDF::NcVar& var, const std::vector<size_t>& _starts, const std::vector<size_t>& _counts, const std::vector<ptrdiff_t>& _strides, T* buffer) const {
+		size_t n = std::accumulate(_counts.begin(), _counts.end(), size_t(1), std::multiplies<size_t>());
+		if constexpr (std::is_floating_point<T>::value){
+			if (unpack_on_read && packed_type == netCDF::NcType::nc_SHORT){
+				thread_local std::vector<int16_t> packed;
+				packed.resize(n);
+				get_var(var, _starts, _counts, _strides, packed.data());
+				unpack<int16_t, T>(packed.data(), buffer, n, scale_factor, add_offset, int16_t(fill_value), has_fill);
+				return;
+			}
+			if (unpack_on_read && packed_type == netCDF::NcType::nc_BYTE){
+				thread_local std::vector<int8_t> packed;
+				packed.resize(n);
+				get_var(var, _starts, _counts, _strides, packed.data());
+				unpack<int8_t, T>(packed.data(), buffer, n, scale_factor, add_offset, int8_t(fill_value), has_fill);
+				return;
+			}
+		}
+		get_var(var, _starts, _counts, _strides, buffer);
+		unpack_buffer(buffer, n);
+	}
+
+	// read a hyperslab from var in its type U. A hyperslab that wraps around the longitude axis is read
+	// as one piece per period, each written straight to its place in buffer.
+	template <class U>
+	void get_var(const netCDF::NcVar& var, const std::vector<size_t>& _starts, const std::vector<size_t>& _counts, const std::vector<ptrdiff_t>& _strides, U* buffer) const {
+		if (!lon_wraps(_starts, _counts)){
+			get_var(var, _starts, _counts, _strides, buffer, nullptr);
+			return;
+		}
+		if (_strides[lon_idx] != 1) throw std::runtime_error("read: strides along a wrapped longitude range are not supported");
+
+		thread_local std::vector<size_t> s, c;
+		thread_local std::vector<ptrdiff_t> imap;
+		s = _starts;
+		c = _counts;
+		size_t nd = c.size();
+		imap.assign(nd, 1);
+		for (int k=int(nd)-2; k>=0; --k) imap[k] = imap[k+1]*_counts[k+1];
+
+		for_each_lon_piece(_starts[lon_idx], _counts[lon_idx], [&](size_t start, size_t count, size_t offset){
+			s[lon_idx] = start;
+			c[lon_idx] = count;
+			get_var(var, s, c, _strides, buffer + offset*imap[lon_idx], &imap);
+		});
+	}
+
+	// read a hyperslab from var in its type U, through the chunk reader if one is set up for this variable.
+	// imap (optional) is the layout of buffer, as in netCDF's varm functions.
+	template <class U>
+	void get_var(const netCDF::NcVar& var, const std::vector<size_t>& _starts, const std::vector<size_t>& _counts, const std::vector<ptrdiff_t>& _strides, U* buffer, const std::vector<ptrdiff_t>* imap) const {
+		size_t n = std::accumulate(_counts.begin(), _counts.end(), size_t(1), std::multiplies<size_t>());
+		if (chunk_reader && var.getId() == ncvar.getId() && var.getParentGroup().getId() == ncvar.getParentGroup().getId()){
+			FLARE_INSTRUMENT_SCOPE("readChunks", io_label, n*sizeof(U), &_counts);
+			if (chunk_reader->read(_starts, _counts, _strides, buffer, decompression_pool, imap)) return;
+		}
+		std::lock_guard<std::mutex> lock(netcdf_mutex(root_ncid(var.getParentGroup().getId())));
+		FLARE_INSTRUMENT_SCOPE("getVar", io_label, n*sizeof(U), &_counts);
+		if (imap) var.getVar(_starts, _counts, _strides, *imap, buffer);
+		else      var.getVar(_starts, _counts, _strides, buffer);
+	}
+
+	// resize the data tensor only if its shape has changed, so that steady-state reads reuse the existing buffer
+	void reshape(const std::vector<size_t>& shape){
+		size_t n = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+		if (shape == tensor_shape && this->vec.size() == n) return;
+		if (verbose) std::cout << "Resizing tensor to: " << shape;
+		this->resize(shape);
+		tensor_shape = shape;
+	}
+
+	// read a block, split into sub-reads according to the read plan if max_read_bytes is set
+	void read_block(const std::vector<size_t>& _starts, const std::vector<size_t>& _counts, const std::vector<ptrdiff_t>& _strides, T* buffer) const {
+		if (max_read_bytes == 0 || !storage.chunked || lon_wraps(_starts, _counts)){ // (wrapped ranges are read in one piece per period)
+			read_hyperslab(ncvar, _starts, _counts, _strides, buffer);
+			return;
+		}
+		ReadPlan plan = make_read_plan(storage, _starts, _counts, _strides, sizeof(T), max_read_bytes);
+		for (size_t i=0; i<plan.sub_starts.size(); ++i){
+			read_hyperslab(ncvar, plan.sub_starts[i], plan.sub_counts[i], _strides, buffer + plan.sub_offsets[i]);
+		}
+	}
+
+	// unpack data that has already been converted to T (in place)
+	void unpack_buffer(T* buffer, size_t n) const {
+		if constexpr (std::is_floating_point<T>::value){
+			if (unpack_on_read) unpack_inplace<T>(buffer, n, scale_factor, add_offset, T(fill_value), has_fill);
+		}
+	}
+
+	// after unpacking, missing values are represented by NaN
+	void set_unpacked_missing_value(){
+		if constexpr (std::is_floating_point<T>::value) this->missing_value = std::numeric_limits<T>::quiet_NaN();
+	}
+
+	// parse a time unit string of the form "<units> since <yyyy-mm-dd> <hh:mm:ss>"
+	// into the unit name, the multiplier to convert it to days, and the base date.
+	// For months and years the multiplier is nominal (mean length in the calendar); use file_time_to_days() to convert exactly.
+	static void parse_time_unit_string(const std::string& unit_str, std::string& _tunit, double& _tscale, std::tm& _t_base, Calendar _cal = Calendar::gregorian){
 		std::string since;
-		std::stringstream ss(in_file.coordunits_map["time"]);
-		ss >> tunit >> since;
+		std::stringstream ss(unit_str);
+		ss >> _tunit >> since;
 
 		if (since != "since") throw std::runtime_error("time unit is not in the correct format (<units> since <yyyy-mm-dd> <hh:mm:ss>)");
 
-		if      (tunit == "days")   tscale = 1;
-		else if (tunit == "hours")  tscale = 1.0/24.0;
-		else if (tunit == "months") tscale = 1.0*365.2425/12;
+		if      (_tunit == "days")   _tscale = 1;
+		else if (_tunit == "hours")  _tscale = 1.0/24.0;
+		else if (_tunit == "months") _tscale = calendar_days_per_year(_cal)/12;
+		else if (_tunit == "years")  _tscale = calendar_days_per_year(_cal);
+
+		_t_base = {};
+		std::stringstream ss1(unit_str);
+		ss1 >> std::get_time(&_t_base, std::string(_tunit + " since %Y-%m-%d %H:%M:%S").c_str());
+	}
+
+	// convert a time value in file units to days since the base date (in the calendar). Months and years are
+	// converted exactly, by calendar arithmetic on the base date (a fractional month is a fraction of that month)
+	static double file_time_to_days(double v, const std::string& _tunit, double _tscale, const std::tm& _t_base, Calendar _cal){
+		if ((_tunit != "months" && _tunit != "years") || _cal == Calendar::day_360) return v*_tscale; // exact
+		double months = (_tunit == "years")? 12*v : v;
+		int y = _t_base.tm_year+1900, m = _t_base.tm_mon+1, d = _t_base.tm_mday;
+		return calendar_add_months(_cal, y, m, d, months) - calendar_days(_cal, y, m, d);
+	}
+
+	void parse_time_unit(NcFilePP &in_file){
+		// calendar attribute of the time variable (Gregorian if absent)
+		std::string tname = ncvar.getDim(t_idx).getName();
+		calendar = Calendar::gregorian;
+		auto tv = in_file.coords_map.find(tname);
+		if (tv != in_file.coords_map.end()){
+			std::string cal;
+			try{ tv->second.getAtt("calendar").getValues(cal); calendar = calendar_from_string(cal); }
+			catch(netCDF::exceptions::NcException &e){}
+		}
+
+		parse_time_unit_string(in_file.coordunits_map["time"], tunit, tscale, t_base, calendar);
+		julian_base = date_to_julian(t_base);
+		calendar_base = date_to_calendar_days(calendar, t_base);
 
 		tstep = 0;
-		auto& tvec = coords_trimmed[t_idx];
-		for (auto& t : tvec) t *= tscale; // convert time vector to "days since base date"
+		auto& tvec = coords_trimmed[t_idx].mut();
+		for (auto& t : tvec) t = file_time_to_days(t, tunit, tscale, t_base, calendar); // convert time vector to "days since base date"
 
 		if (tvec.size() > 1) tstep = (tvec[tvec.size()-1]-tvec[0])/(tvec.size()-1); // get timestep in days
-
-		std::stringstream ss1(in_file.coordunits_map["time"]);
-		ss1 >> std::get_time(&t_base, std::string(tunit + " since %Y-%m-%d %H:%M:%S").c_str());
 	
 		// std::cout << std::put_time(&t_base, "%Y-%m-%d %H:%M:%S %Z") << '\n';
 		// std::cout << "days since 1970-1-1: " << (std::chrono::duration_cast<std::chrono::hours>(std::chrono::system_clock::from_time_t(std::mktime(&t_base)).time_since_epoch())).count() << "\n";
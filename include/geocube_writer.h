@@ -0,0 +1,301 @@
+#ifndef FLARE_FLARE_GEOCUBE_WRITER_H
+#define FLARE_FLARE_GEOCUBE_WRITER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <type_traits>
+#include <cstdio>
+
+#include "geocube.h"
+#include "cube_view.h"
+
+namespace flare{
+
+/// @brief  netCDF type corresponding to a C++ type
+template <class T>
+netCDF::NcType nc_type_of(){
+	if      constexpr (std::is_same<T, float>::value)   return netCDF::ncFloat;
+	else if constexpr (std::is_same<T, double>::value)  return netCDF::ncDouble;
+	else if constexpr (std::is_same<T, int>::value)     return netCDF::ncInt;
+	else if constexpr (std::is_same<T, short>::value)   return netCDF::ncShort;
+	else if constexpr (std::is_same<T, signed char>::value) return netCDF::ncByte;
+	else static_assert(!std::is_same<T, T>::value, "nc_type_of: unsupported type");
+}
+
+
+/// @brief  Options for creating an output file
+struct WriterOptions {
+	AccessPattern pattern = AccessPattern::time_slice; // expected access pattern of readers, used to choose chunk shapes
+	std::vector<size_t> chunks;        // explicit chunk shape (in the cube's dim order), overrides pattern
+	size_t target_chunk_bytes = 1<<20; // approximate chunk size when chunks are chosen automatically
+	int deflate_level = 1;             // 0 = no compression
+	bool shuffle = true;               // byte shuffle before deflate (improves compression of floats)
+	size_t queue_slices = 8;           // max number of slices waiting to be written before append() blocks
+};
+
+
+/// @brief  Writes a variable with the same dimensions, coordinates and attributes as a GeoCube
+///         (over its current spatial window) to a new netCDF-4 file, and appends time slices
+///         along an unlimited time dimension.
+///         Slices are copied into a bounded queue and written (and compressed) on a background
+///         thread, a whole chunk length of time steps at a time, so that append() returns
+///         immediately unless the writer falls more than queue_slices behind. The writer thread
+///         buffers up to one chunk length of slices.
+///         Errors on the writer thread are rethrown by the next call to append() or close().
+template <class T>
+class GeoCubeWriter {
+	public:
+	std::vector<size_t> chunks;  // chunk shape used for the variable
+
+	private:
+	netCDF::NcFile file;
+	netCDF::NcVar var, tvar;
+	int t_idx, lat_idx, lon_idx;
+	std::vector<size_t> slice_counts;
+	size_t slice_size;
+	double julian_base;
+	Calendar calendar;
+	double calendar_base;
+	size_t t_written = 0;        // number of slices written to the file
+
+	struct Item { std::vector<T> data; double t; };
+	std::deque<Item> queue;
+	std::mutex mtx;
+	std::condition_variable cv;
+	size_t queue_slices;
+	bool closing = false;
+	std::exception_ptr error;
+	std::thread worker;
+
+	public:
+	/// @param like    cube whose variable, dims, coords (trimmed) and attributes are replicated. Must have a time dimension.
+	GeoCubeWriter(const std::string& path, const GeoCube<T>& like, WriterOptions opt = WriterOptions())
+		: t_idx(like.t_idx), lat_idx(like.lat_idx), lon_idx(like.lon_idx), queue_slices(std::max(opt.queue_slices, size_t(1))) {
+		if (like.t_idx < 0) throw std::runtime_error("GeoCubeWriter: variable does not have a time dimension");
+
+		slice_counts = like.sliceCounts();
+		slice_size = like.sliceSize();
+		julian_base = like.getJulianBase();
+		calendar = like.getCalendar();
+		calendar_base = like.getCalendarBase();
+		chunks = (opt.chunks.empty())? choose_chunks(opt) : opt.chunks;
+		if (chunks.size() != slice_counts.size()) throw std::runtime_error("GeoCubeWriter: chunk shape has wrong number of dimensions");
+
+		std::lock_guard<std::mutex> lock(netcdf_mutex());
+		file.open(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+
+		// dimensions and coordinate variables
+		std::vector<netCDF::NcDim> dims;
+		for (size_t i=0; i<like.dimnames.size(); ++i){
+			auto& name = like.dimnames[i];
+			bool is_t = (int(i) == t_idx);
+			netCDF::NcDim d = (is_t)? file.addDim(name) : file.addDim(name, slice_counts[i]);
+			dims.push_back(d);
+
+			netCDF::NcVar cvar = file.addVar(name, netCDF::ncDouble, d);
+			if (is_t){
+				cvar.putAtt("units", "days since " + base_string());
+				cvar.putAtt("calendar", calendar_name(calendar));
+				tvar = cvar;
+			}
+			else {
+				if      (int(i) == like.lat_idx) cvar.putAtt("units", "degrees_north");
+				else if (int(i) == like.lon_idx) cvar.putAtt("units", "degrees_east");
+				cvar.putVar(like.coords_trimmed[i].data());
+			}
+		}
+
+		// data variable
+		var = file.addVar(like.name, nc_type_of<T>(), dims);
+		var.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+		if (opt.deflate_level > 0 || opt.shuffle) var.setCompression(opt.shuffle, opt.deflate_level > 0, opt.deflate_level);
+		var.putAtt("_FillValue", nc_type_of<T>(), like.missing_value);
+		var.putAtt("missing_value", nc_type_of<T>(), like.missing_value);
+		if (like.unit != "") var.putAtt("units", like.unit);
+		if (!like.unpack_on_read && (like.scale_factor != 1 || like.add_offset != 0)){ // data is still in packed units
+			var.putAtt("scale_factor", netCDF::ncFloat, like.scale_factor);
+			var.putAtt("add_offset", netCDF::ncFloat, like.add_offset);
+		}
+
+		worker = std::thread([this](){ run(); });
+	}
+
+	~GeoCubeWriter(){
+		try { close(); }
+		catch (std::exception& e){ std::cout << "GeoCubeWriter: error while closing: " << e.what() << "\n"; }
+	}
+
+	GeoCubeWriter(const GeoCubeWriter&) = delete;
+	GeoCubeWriter& operator=(const GeoCubeWriter&) = delete;
+
+	/// @brief              queue a time slice for writing (the data is copied)
+	/// @param julian_day   time of the slice
+	void append(const T* slice, double julian_day){
+		push(std::vector<T>(slice, slice + slice_size), julian_day);
+	}
+
+	/// @brief   queue the current contents of a cube (which must hold a single time slice)
+	void append(const GeoCube<T>& cube, double julian_day){
+		if (cube.vec.size() != slice_size) throw std::runtime_error("GeoCubeWriter: cube does not hold a single slice of the output shape");
+		append(cube.vec.data(), julian_day);
+	}
+
+	/// @brief   queue a single time slice given as a view (e.g. one time step of a loaded block).
+	///          The view must have the dims of the output (in the same order, time with count 1).
+	///          The slice is packed directly into the queue, without an intermediate copy.
+	template <class U>
+	void append(const CubeView<U>& slice, double julian_day){
+		if (slice.shape.size() != slice_counts.size() || slice.lat_idx != lat_idx || slice.lon_idx != lon_idx)
+			throw std::runtime_error("GeoCubeWriter: view does not have the dims of the output");
+		for (size_t d=0; d<slice_counts.size(); ++d){
+			if (slice.shape[d] != slice_counts[d])
+				throw std::runtime_error("GeoCubeWriter: view has " + std::to_string(slice.shape[d]) + " elements along dim " + std::to_string(d) + ", expected " + std::to_string(slice_counts[d]));
+		}
+		std::vector<T> data(slice_size);
+		slice.copyTo(data.data());
+		push(std::move(data), julian_day);
+	}
+
+	/// @brief   write all queued slices and close the file
+	void close(){
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (closing) return;
+			closing = true;
+		}
+		cv.notify_all();
+		if (worker.joinable()) worker.join();
+		{
+			std::lock_guard<std::mutex> lock(netcdf_mutex());
+			file.close();
+		}
+		if (error) std::rethrow_exception(error);
+	}
+
+	/// @brief   number of slices written to the file so far
+	size_t written(){
+		std::lock_guard<std::mutex> lock(mtx);
+		return t_written;
+	}
+
+	private:
+
+	void push(std::vector<T>&& data, double julian_day){
+		std::unique_lock<std::mutex> lock(mtx);
+		cv.wait(lock, [this](){ return queue.size() < queue_slices || error; });
+		if (error) std::rethrow_exception(error);
+		if (closing) throw std::runtime_error("GeoCubeWriter: append() after close()");
+		queue.push_back(Item{std::move(data), julian_day});
+		cv.notify_all();
+	}
+
+	// time base as "yyyy-mm-dd hh:mm:ss", in the calendar of the output
+	std::string base_string() const {
+		int y, m, d, h, mi;
+		double s;
+		calendar_days_to_ymdhms(calendar, calendar_base, y, m, d, h, mi, s);
+		char buf[64];
+		std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d", y, m, d, h, mi, int(std::lround(s)));
+		return buf;
+	}
+
+	std::vector<size_t> choose_chunks(const WriterOptions& opt) const {
+		std::vector<size_t> c = slice_counts;
+		size_t per_elem = sizeof(T);
+		if (opt.pattern == AccessPattern::time_slice){
+			// one time step per chunk; split the slice along its outermost dims until it fits the target size
+			c[t_idx] = 1;
+			for (size_t d=0; d<c.size(); ++d){
+				if (int(d) == t_idx) continue;
+				size_t bytes = std::accumulate(c.begin(), c.end(), per_elem, std::multiplies<size_t>());
+				if (bytes <= opt.target_chunk_bytes) break;
+				c[d] = std::max(size_t(1), c[d]*opt.target_chunk_bytes/bytes);
+			}
+		}
+		else {
+			// long time series over small square lat/lon tiles
+			c[t_idx] = 128;
+			size_t other = 1;
+			for (size_t d=0; d<c.size(); ++d) if (int(d) != t_idx && int(d) != lat_idx && int(d) != lon_idx) other *= c[d];
+			size_t tile = std::max(size_t(1), size_t(std::sqrt(double(opt.target_chunk_bytes)/(per_elem*c[t_idx]*other))));
+			c[lat_idx] = std::min(c[lat_idx], tile);
+			c[lon_idx] = std::min(c[lon_idx], tile);
+		}
+		return c;
+	}
+
+	// background thread: collect queued slices into blocks of one chunk length along time, and write each block at once
+	void run(){
+		size_t block_len = chunks[t_idx];
+		std::vector<T> block;
+		std::vector<double> times;
+		while (true){
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				cv.wait(lock, [this](){ return !queue.empty() || closing; });
+				while (!queue.empty() && times.size() < block_len){
+					block.insert(block.end(), queue.front().data.begin(), queue.front().data.end());
+					times.push_back(queue.front().t);
+					queue.pop_front();
+				}
+				cv.notify_all();
+				bool done = closing && queue.empty();
+				if (done && times.empty()) return;
+				if (!done && times.size() < block_len) continue; // wait for the rest of the block
+			}
+
+			try {
+				write_block(block, times);
+			}
+			catch (...){
+				std::lock_guard<std::mutex> lock(mtx);
+				error = std::current_exception();
+				cv.notify_all();
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				t_written += times.size();
+			}
+			block.clear();
+			times.clear();
+		}
+	}
+
+	void write_block(const std::vector<T>& block, const std::vector<double>& times){
+		if (times.empty()) return;
+		size_t nt = times.size();
+
+		// the queue holds whole slices one after the other; reorder if time is not the outermost dim
+		const T* data = block.data();
+		std::vector<T> reordered;
+		size_t outer = 1;
+		for (int d=0; d<t_idx; ++d) outer *= slice_counts[d];
+		if (outer > 1){
+			size_t inner = slice_size/outer;
+			reordered.resize(block.size());
+			for (size_t k=0; k<nt; ++k)
+				for (size_t o=0; o<outer; ++o)
+					std::copy(block.begin() + k*slice_size + o*inner, block.begin() + k*slice_size + (o+1)*inner, reordered.begin() + (o*nt + k)*inner);
+			data = reordered.data();
+		}
+
+		std::vector<size_t> start(slice_counts.size(), 0), count = slice_counts;
+		start[t_idx] = t_written;
+		count[t_idx] = nt;
+
+		std::vector<double> tvals(nt);
+		for (size_t k=0; k<nt; ++k) tvals[k] = julian_to_days_since(calendar, times[k], julian_base, calendar_base);
+
+		std::lock_guard<std::mutex> lock(netcdf_mutex(file.getId()));
+		tvar.putVar(std::vector<size_t>{t_written}, std::vector<size_t>{nt}, tvals.data());
+		var.putVar(start, count, data);
+	}
+};
+
+} // namespace flare
+
+#endif
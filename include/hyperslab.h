@@ -0,0 +1,39 @@
+#ifndef FLARE_FLARE_HYPERSLAB_H
+#define FLARE_FLARE_HYPERSLAB_H
+
+#include <vector>
+#include <string>
+#include <numeric>
+#include <functional>
+#include <iostream>
+#include <cstddef>
+
+#include "utils.h"
+
+namespace flare{
+
+/// @brief  A hyperslab of a variable: start, count and stride along each dim (in the variable's dim order).
+///         Used as a query object for reads that do not modify the cube (see GeoCube::read()).
+struct Hyperslab {
+	std::vector<size_t> starts, counts;
+	std::vector<ptrdiff_t> strides;
+
+	/// @brief   number of elements
+	size_t size() const {
+		return std::accumulate(counts.begin(), counts.end(), size_t(1), std::multiplies<size_t>());
+	}
+
+	bool operator==(const Hyperslab& o) const {
+		return starts == o.starts && counts == o.counts && strides == o.strides;
+	}
+
+	void print(std::string prefix = "") const {
+		std::cout << prefix << "starts:  " << starts;
+		std::cout << prefix << "counts:  " << counts;
+		std::cout << prefix << "strides: " << strides;
+	}
+};
+
+} // namespace flare
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef FLARE_FLARE_INSTRUMENT_H
+#define FLARE_FLARE_INSTRUMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <iostream>
+
+#include "utils.h"
+
+// I/O instrumentation: counts calls, bytes and hyperslab shapes, and times netCDF reads (getVar)
+// and metadata reading (readMeta), per label (file path, or file path and variable name).
+// Off by default; enable at runtime with flare::instrument::enable(). When disabled, each
+// instrumented call costs one relaxed atomic load. Define FLARE_NO_INSTRUMENTATION to compile
+// the hooks out entirely.
+
+namespace flare{
+namespace instrument{
+
+/// @brief  Accumulated counters for one kind of operation on one label
+struct Counters {
+	size_t calls = 0;
+	size_t bytes = 0;
+	double seconds = 0;
+	std::map<std::vector<size_t>, size_t> shapes; // hyperslab shape --> number of calls
+
+	void print(std::string prefix = "") const {
+		std::cout << prefix << calls << " calls, " << bytes/1e6 << " MB, " << seconds*1e3 << " ms";
+		if (seconds > 0 && bytes > 0) std::cout << " (" << bytes/1e6/seconds << " MB/s)";
+		std::cout << "\n";
+		for (auto& s : shapes) std::cout << prefix << "   shape " << s.first << "      x " << s.second << "\n";
+	}
+};
+
+/// @brief  Snapshot of all counters: kind ("getVar", "GeoCube::readMeta", ...) --> label --> counters
+using Snapshot = std::map<std::string, std::map<std::string, Counters>>;
+
+/// @brief  One timed call, for trace export
+struct Event {
+	const char* kind;
+	std::string label;
+	double ts_us, dur_us;  // start (since the registry was created) and duration [us]
+	size_t bytes;
+	size_t tid;
+};
+
+
+class Registry {
+	private:
+	std::mutex mtx;
+	Snapshot counters;
+	std::vector<Event> events;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+	public:
+	std::atomic<bool> enabled{false};
+	std::atomic<bool> tracing{false};  // also record individual events (for trace export)
+	size_t max_events = 1000000;       // events beyond this are dropped
+
+	static Registry& instance(){
+		static Registry r;
+		return r;
+	}
+
+	void record(const char* kind, const std::string& label, size_t bytes, const std::vector<size_t>* shape,
+	            std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+		double dur = std::chrono::duration<double>(end - start).count();
+		std::lock_guard<std::mutex> lock(mtx);
+		Counters& c = counters[kind][label];
+		++c.calls;
+		c.bytes += bytes;
+		c.seconds += dur;
+		if (shape) ++c.shapes[*shape];
+		if (tracing && events.size() < max_events){
+			events.push_back(Event{kind, label,
+			                       std::chrono::duration<double, std::micro>(start - t0).count(), dur*1e6,
+			                       bytes, std::hash<std::thread::id>()(std::this_thread::get_id())});
+		}
+	}
+
+	Snapshot snapshot(){
+		std::lock_guard<std::mutex> lock(mtx);
+		return counters;
+	}
+
+	void reset(){
+		std::lock_guard<std::mutex> lock(mtx);
+		counters.clear();
+		events.clear();
+	}
+
+	/// @brief   write recorded events in Chrome trace format (open in chrome://tracing or Perfetto)
+	void writeChromeTrace(const std::string& path){
+		std::lock_guard<std::mutex> lock(mtx);
+		std::ofstream fout(path);
+		if (!fout) throw std::runtime_error("instrument: cannot open " + path + " for writing");
+		fout << "{\"traceEvents\":[\n";
+		for (size_t i=0; i<events.size(); ++i){
+			auto& e = events[i];
+			fout << "{\"name\":\"" << e.kind << "\",\"cat\":\"" << escape(e.label) << "\",\"ph\":\"X\""
+			     << ",\"ts\":" << e.ts_us << ",\"dur\":" << e.dur_us << ",\"pid\":1,\"tid\":" << (e.tid % 100000)
+			     << ",\"args\":{\"label\":\"" << escape(e.label) << "\",\"bytes\":" << e.bytes << "}}"
+			     << ((i+1 < events.size())? ",\n" : "\n");
+		}
+		fout << "]}\n";
+	}
+
+	/// @brief   write the counters as JSON
+	void writeJson(const std::string& path){
+		Snapshot s = snapshot();
+		std::ofstream fout(path);
+		if (!fout) throw std::runtime_error("instrument: cannot open " + path + " for writing");
+		fout << "{";
+		bool first_kind = true;
+		for (auto& k : s){
+			fout << (first_kind? "" : ",") << "\n \"" << k.first << "\": {";
+			first_kind = false;
+			bool first_label = true;
+			for (auto& l : k.second){
+				auto& c = l.second;
+				fout << (first_label? "" : ",") << "\n  \"" << escape(l.first) << "\": {\"calls\": " << c.calls
+				     << ", \"bytes\": " << c.bytes << ", \"seconds\": " << c.seconds << ", \"shapes\": [";
+				first_label = false;
+				bool first_shape = true;
+				for (auto& sh : c.shapes){
+					fout << (first_shape? "" : ", ") << "{\"shape\": [";
+					for (size_t d=0; d<sh.first.size(); ++d) fout << (d? ", " : "") << sh.first[d];
+					fout << "], \"calls\": " << sh.second << "}";
+					first_shape = false;
+				}
+				fout << "]}";
+			}
+			fout << "\n }";
+		}
+		fout << "\n}\n";
+	}
+
+	void print(){
+		Snapshot s = snapshot();
+		std::cout << "I/O stats >\n";
+		for (auto& k : s){
+			for (auto& l : k.second){
+				std::cout << "   " << k.first << " [" << l.first << "]: ";
+				l.second.print("   ");
+			}
+		}
+	}
+
+	private:
+	static std::string escape(const std::string& s){
+		std::string out;
+		for (char c : s){
+			if (c == '"' || c == '\\') out += '\\';
+			out += c;
+		}
+		return out;
+	}
+};
+
+
+inline void enable(bool on = true, bool trace = false){
+	Registry::instance().enabled = on;
+	Registry::instance().tracing = trace;
+}
+
+inline bool enabled(){
+	return Registry::instance().enabled.load(std::memory_order_relaxed);
+}
+
+inline Snapshot snapshot(){
+	return Registry::instance().snapshot();
+}
+
+inline void reset(){
+	Registry::instance().reset();
+}
+
+
+/// @brief  Times the enclosing scope and records it on destruction (if instrumentation is enabled)
+class Scope {
+	private:
+	bool active;
+	const char* kind;
+	std::string label;  // (copied, since it may be a temporary; only when enabled)
+	size_t bytes;
+	const std::vector<size_t>* shape;
+	std::chrono::steady_clock::time_point start;
+
+	public:
+	Scope(const char* _kind, const std::string& _label, size_t _bytes = 0, const std::vector<size_t>* _shape = nullptr)
+		: active(enabled()), kind(_kind), bytes(_bytes), shape(_shape) {
+		if (!active) return;
+		label = _label;
+		start = std::chrono::steady_clock::now();
+	}
+
+	~Scope(){
+		if (active) Registry::instance().record(kind, label, bytes, shape, start, std::chrono::steady_clock::now());
+	}
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+};
+
+} // namespace instrument
+} // namespace flare
+
+
+#ifdef FLARE_NO_INSTRUMENTATION
+#define FLARE_INSTRUMENT_SCOPE(...)
+#else
+/// time the rest of the enclosing scope: FLARE_INSTRUMENT_SCOPE(kind, label [, bytes [, &shape]])
+#define FLARE_INSTRUMENT_SCOPE(...) flare::instrument::Scope flare_instrument_scope_(__VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef FLARE_FLARE_META_CACHE_H
+#define FLARE_FLARE_META_CACHE_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+namespace flare{
+
+/// @brief  Identifies a file version: a file is considered unchanged if its path, size and modification time are.
+struct FileStamp {
+	std::string path;
+	int64_t mtime_ns = 0;
+	int64_t size = 0;
+
+	/// @brief  stamp of the file at path (empty path if it cannot be stat'ed)
+	static FileStamp of(const std::string& path){
+		FileStamp s;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) return s;
+		s.path = path;
+		s.mtime_ns = int64_t(st.st_mtim.tv_sec)*1000000000 + st.st_mtim.tv_nsec;
+		s.size = st.st_size;
+		return s;
+	}
+
+	bool operator==(const FileStamp& o) const {
+		return path == o.path && mtime_ns == o.mtime_ns && size == o.size;
+	}
+};
+
+
+/// @brief  Values of a coordinate axis. Copies share one immutable array, so that the metadata cache, files and
+///         cubes hold a single copy of each axis. Reads behave as on a const std::vector<double> (to which it converts);
+///         mut() gives write access, copying the values first if they are shared. The reference returned by mut()
+///         is valid until the array is copied or reassigned.
+class CoordArray {
+	private:
+	std::shared_ptr<const std::vector<double>> p;
+	bool writable = false;  // whether p was allocated by this object (and may be modified in place when not shared)
+
+	public:
+	CoordArray(){}
+	CoordArray(std::shared_ptr<const std::vector<double>> v) : p(std::move(v)) {}
+	CoordArray(std::shared_ptr<std::vector<double>> v) : p(std::move(v)) {}
+	CoordArray(std::vector<double> v) : p(std::make_shared<std::vector<double>>(std::move(v))), writable(true) {}
+	CoordArray(std::initializer_list<double> v) : CoordArray(std::vector<double>(v)) {}
+
+	const std::vector<double>& get() const {
+		static const std::vector<double> empty_vector;
+		return p? *p : empty_vector;
+	}
+	operator const std::vector<double>&() const {
+		return get();
+	}
+
+	/// @brief   the shared array (e.g. to store it elsewhere without copying)
+	std::shared_ptr<const std::vector<double>> shared() const {
+		return p? p : std::make_shared<const std::vector<double>>();
+	}
+
+	/// @brief   writable values of this axis (a private copy, if they are shared)
+	std::vector<double>& mut(){
+		if (!writable || p.use_count() > 1){
+			p = std::make_shared<std::vector<double>>(get());
+			writable = true;
+		}
+		return const_cast<std::vector<double>&>(*p);
+	}
+
+	template <class It>
+	void assign(It first, It last){
+		p = std::make_shared<std::vector<double>>(first, last);
+		writable = true;
+	}
+
+	size_t size() const { return get().size(); }
+	bool empty() const { return get().empty(); }
+	const double* data() const { return get().data(); }
+	double operator[](size_t i) const { return get()[i]; }
+	double at(size_t i) const { return get().at(i); }
+	double front() const { return get().front(); }
+	double back() const { return get().back(); }
+	std::vector<double>::const_iterator begin() const { return get().begin(); }
+	std::vector<double>::const_iterator end() const { return get().end(); }
+
+	friend bool operator==(const CoordArray& a, const CoordArray& b){ return a.p == b.p || a.get() == b.get(); }
+	friend bool operator!=(const CoordArray& a, const CoordArray& b){ return !(a == b); }
+	friend bool operator==(const CoordArray& a, const std::vector<double>& b){ return a.get() == b; }
+	friend bool operator!=(const CoordArray& a, const std::vector<double>& b){ return a.get() != b; }
+	friend bool operator==(const std::vector<double>& a, const CoordArray& b){ return a == b.get(); }
+	friend bool operator!=(const std::vector<double>& a, const CoordArray& b){ return a != b.get(); }
+
+	// (a friend, found by argument-dependent lookup only, so that it does not hide ::operator<< for vectors in flare)
+	friend std::ostream& operator << (std::ostream& os, const CoordArray& v){
+		return ::operator<<(os, v.get());
+	}
+};
+
+
+/// @brief  Coordinate metadata of a file: units and values of all coordinate variables.
+///         Values are immutable and shared between all files/cubes that use them.
+struct CoordMeta {
+	std::map<std::string, std::string> units;
+	std::map<std::string, std::shared_ptr<const std::vector<double>>> values;
+};
+
+
+/// @brief  Process-wide cache of coordinate metadata, keyed by file stamp, so that reopening a file
+///         does not re-read its coordinate arrays. Holds up to max_entries files, evicting the least
+///         recently used. Optionally, entries are also persisted as sidecar files in a directory, so
+///         that they survive across runs.
+class MetaCache {
+	private:
+	struct Entry {
+		FileStamp stamp;
+		std::shared_ptr<const CoordMeta> meta;
+		std::list<std::string>::iterator lru_pos;
+	};
+	std::mutex mtx;
+	std::map<std::string, Entry> entries;  // path --> entry
+	std::list<std::string> lru;            // paths, most recently used first
+	std::string sidecar_dir;
+	size_t max_entries = 1024;
+
+	public:
+	bool enabled = true;
+
+	static MetaCache& instance(){
+		static MetaCache cache;
+		return cache;
+	}
+
+	/// @brief   also persist entries in dir (empty = in-process only)
+	void setSidecarDir(const std::string& dir){
+		std::lock_guard<std::mutex> lock(mtx);
+		sidecar_dir = dir;
+	}
+
+	/// @brief   maximum number of files held in memory (sidecars are not limited)
+	void setMaxEntries(size_t n){
+		std::lock_guard<std::mutex> lock(mtx);
+		max_entries = std::max(n, size_t(1));
+		evict();
+	}
+
+	/// @brief   cached metadata for the file, or nullptr if there is none (or the file has changed)
+	std::shared_ptr<const CoordMeta> find(const FileStamp& stamp){
+		if (!enabled || stamp.path.empty()) return nullptr;
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = entries.find(stamp.path);
+		if (it != entries.end()){
+			if (it->second.stamp == stamp){
+				lru.splice(lru.begin(), lru, it->second.lru_pos);
+				return it->second.meta;
+			}
+			erase(it); // stale
+		}
+		if (!sidecar_dir.empty()){
+			auto meta = load_sidecar(stamp);
+			if (meta) insert(stamp, meta);
+			return meta;
+		}
+		return nullptr;
+	}
+
+	void put(const FileStamp& stamp, std::shared_ptr<const CoordMeta> meta){
+		if (!enabled || stamp.path.empty()) return;
+		std::lock_guard<std::mutex> lock(mtx);
+		insert(stamp, meta);
+		if (!sidecar_dir.empty()) save_sidecar(stamp, *meta);
+	}
+
+	void clear(){
+		std::lock_guard<std::mutex> lock(mtx);
+		entries.clear();
+		lru.clear();
+	}
+
+	size_t size(){
+		std::lock_guard<std::mutex> lock(mtx);
+		return entries.size();
+	}
+
+	private:
+	void insert(const FileStamp& stamp, std::shared_ptr<const CoordMeta> meta){
+		auto it = entries.find(stamp.path);
+		if (it != entries.end()) erase(it);
+		lru.push_front(stamp.path);
+		entries[stamp.path] = Entry{stamp, meta, lru.begin()};
+		evict();
+	}
+
+	void erase(std::map<std::string, Entry>::iterator it){
+		lru.erase(it->second.lru_pos);
+		entries.erase(it);
+	}
+
+	void evict(){
+		while (entries.size() > max_entries) erase(entries.find(lru.back()));
+	}
+
+	std::string sidecar_path(const std::string& path) const {
+		return sidecar_dir + "/" + std::to_string(std::hash<std::string>()(path)) + ".flaremeta";
+	}
+
+	// sidecar format: stamp, then for each coord: name, unit, n, values
+	static void write_string(std::ofstream& f, const std::string& s){
+		uint64_t n = s.size();
+		f.write((const char*)&n, sizeof(n));
+		f.write(s.data(), n);
+	}
+
+	static bool read_string(std::ifstream& f, std::string& s){
+		uint64_t n;
+		if (!f.read((char*)&n, sizeof(n))) return false;
+		s.resize(n);
+		return bool(f.read(&s[0], n));
+	}
+
+	void save_sidecar(const FileStamp& stamp, const CoordMeta& meta) const {
+		std::string p = sidecar_path(stamp.path);
+		std::string tmp = p + "." + std::to_string(getpid()) + ".tmp"; // (other processes may be writing the same sidecar)
+		std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+		if (!f) return; // sidecars are an optimization only
+		write_string(f, stamp.path);
+		f.write((const char*)&stamp.mtime_ns, sizeof(int64_t));
+		f.write((const char*)&stamp.size, sizeof(int64_t));
+		uint64_t n = meta.values.size();
+		f.write((const char*)&n, sizeof(n));
+		for (auto& v : meta.values){
+			write_string(f, v.first);
+			write_string(f, meta.units.at(v.first));
+			uint64_t nv = v.second->size();
+			f.write((const char*)&nv, sizeof(nv));
+			f.write((const char*)v.second->data(), nv*sizeof(double));
+		}
+		f.close();
+		if (f) std::rename(tmp.c_str(), p.c_str()); // atomic replace, so concurrent readers never see a partial file
+		else   std::remove(tmp.c_str());
+	}
+
+	std::shared_ptr<const CoordMeta> load_sidecar(const FileStamp& stamp) const {
+		std::ifstream f(sidecar_path(stamp.path), std::ios::binary);
+		if (!f) return nullptr;
+		FileStamp s;
+		if (!read_string(f, s.path)) return nullptr;
+		f.read((char*)&s.mtime_ns, sizeof(int64_t));
+		f.read((char*)&s.size, sizeof(int64_t));
+		if (!f || !(s == stamp)) return nullptr;
+
+		auto meta = std::make_shared<CoordMeta>();
+		uint64_t n;
+		if (!f.read((char*)&n, sizeof(n))) return nullptr;
+		for (uint64_t i=0; i<n; ++i){
+			std::string name, unit;
+			uint64_t nv;
+			if (!read_string(f, name) || !read_string(f, unit) || !f.read((char*)&nv, sizeof(nv))) return nullptr;
+			auto vals = std::make_shared<std::vector<double>>(nv);
+			if (!f.read((char*)vals->data(), nv*sizeof(double))) return nullptr;
+			meta->units[name] = unit;
+			meta->values[name] = vals;
+		}
+		return meta;
+	}
+};
+
+} // namespace flare
+
+#endif
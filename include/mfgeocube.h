@@ -0,0 +1,248 @@
+#ifndef FLARE_FLARE_MFGEOCUBE_H
+#define FLARE_FLARE_MFGEOCUBE_H
+
+#include <glob.h>
+#include <list>
+#include <memory>
+#include "geocube.h"
+
+namespace flare{
+
+/// @brief  A GeoCube whose time axis is the concatenation of the time axes of several files
+///         (e.g. one file per year). Full metadata is read only from the first file; from the
+///         other files only the time coordinate and its units are read. File handles are opened
+///         on demand, and at most max_open_files of them are kept open at a time.
+///         Time indices used with this cube (julian_to_index, readBlock etc) refer to the joined axis.
+template <class T>
+class MFGeoCube : public GeoCube<T> {
+	public:
+	std::vector<std::string> files;
+	size_t max_open_files = 8;
+
+	protected:
+	NcFilePP first_file;                 // first file, always open (holds this->ncvar)
+	std::vector<size_t> file_offsets;    // index of first time slice of each file in the joined axis (size = nfiles+1)
+
+	struct Handle {
+		std::unique_ptr<NcFilePP> file;
+		netCDF::NcVar var;
+	};
+	mutable std::map<size_t, Handle> handles;   // open files, by file index
+	mutable std::list<size_t> handles_lru;      // most recently used file at the front
+	mutable std::mutex handles_mutex;
+
+	public:
+	/// @brief           expand a glob pattern into a sorted list of files
+	static std::vector<std::string> glob_files(const std::string& pattern){
+		glob_t g;
+		std::vector<std::string> paths;
+		if (glob(pattern.c_str(), 0, nullptr, &g) == 0){
+			for (size_t i=0; i<g.gl_pathc; ++i) paths.push_back(g.gl_pathv[i]);
+		}
+		globfree(&g);
+		std::sort(paths.begin(), paths.end());
+		return paths;
+	}
+
+	/// @brief           open a set of files matching a glob pattern, e.g. "data/gpp.*.nc"
+	void open(const std::string& pattern, std::string varname = ""){
+		std::vector<std::string> paths = glob_files(pattern);
+		if (paths.empty()) throw std::runtime_error("MFGeoCube: no files match " + pattern);
+		open(paths, varname);
+	}
+
+	/// @brief           open a list of files, in the order in which their time axes should be joined
+	void open(const std::vector<std::string>& paths, std::string varname = ""){
+		if (paths.empty()) throw std::runtime_error("MFGeoCube: empty file list");
+		files = paths;
+
+		first_file.open(files[0], netCDF::NcFile::read);
+		first_file.readMeta();
+		this->readMeta(first_file, varname);
+
+		if (this->t_idx < 0) throw std::runtime_error("MFGeoCube: variable " + this->name + " does not have a time dimension");
+
+		// name of the time dimension as it appears in the files
+		std::string tname = this->ncvar.getDim(this->t_idx).getName();
+		double cbase = this->calendar_base;
+
+		// build the joined time axis (in days since the base date of the first file, in its calendar)
+		std::vector<double> tjoined;
+		file_offsets.assign(1, 0);
+		for (size_t f=0; f<files.size(); ++f){
+			std::vector<double> tvec;
+			std::string tunit_str;
+			{
+				std::lock_guard<std::mutex> lock(netcdf_mutex());
+				netCDF::NcFile nc(files[f], netCDF::NcFile::read);
+				netCDF::NcVar tvar = nc.getVar(tname);
+				if (tvar.isNull()) throw std::runtime_error("MFGeoCube: time variable " + tname + " not found in " + files[f]);
+				tvec.resize(tvar.getDim(0).getSize());
+				tvar.getVar(tvec.data());
+				tvar.getAtt("units").getValues(tunit_str);
+			}
+
+			std::string funit;
+			double fscale;
+			std::tm fbase;
+			this->parse_time_unit_string(tunit_str, funit, fscale, fbase, this->calendar);
+			double shift = date_to_calendar_days(this->calendar, fbase) - cbase;
+			for (auto t : tvec) tjoined.push_back(this->file_time_to_days(t, funit, fscale, fbase, this->calendar) + shift);
+
+			file_offsets.push_back(tjoined.size());
+		}
+
+		if (!std::is_sorted(tjoined.begin(), tjoined.end())) throw std::runtime_error("MFGeoCube: joined time axis is not monotonic. Check the file order.");
+
+		// the source in slice cache keys is the set of files
+		std::string sources;
+		for (auto& p : files) sources += p + "@" + std::to_string(FileStamp::of(p).mtime_ns) + ";";
+		this->cache_source = "files#" + std::to_string(std::hash<std::string>()(sources));
+		this->io_label = this->cache_source + ":" + this->name;
+
+		// replace time coordinates by the joined axis
+		this->coords_trimmed[this->t_idx] = tjoined;
+		this->coords[this->t_idx] = tjoined;
+		for (auto& t : this->coords[this->t_idx].mut()) t /= this->tscale;  // coords are kept in file units
+		this->dimsizes[this->t_idx] = tjoined.size();
+		if (this->unlim_idx != this->t_idx) this->counts[this->t_idx] = tjoined.size();
+		if (tjoined.size() > 1) this->tstep = (tjoined.back() - tjoined.front())/(tjoined.size()-1);
+		this->build_axis_indices();
+	}
+
+	size_t nfiles() const {
+		return files.size();
+	}
+
+	/// @brief           map an index on the joined time axis to (file index, index within file)
+	std::pair<size_t, size_t> locate(size_t t_index) const {
+		if (t_index >= file_offsets.back()) throw std::runtime_error("MFGeoCube: time index out of range");
+		size_t f = std::upper_bound(file_offsets.begin(), file_offsets.end(), t_index) - file_offsets.begin() - 1;
+		return {f, t_index - file_offsets[f]};
+	}
+
+	void readBlock(double julian_day, bool periodic, bool centred_t) override {
+		size_t it = this->julian_to_index(julian_day, periodic, centred_t);
+		this->starts[this->t_idx] = it;
+		this->counts[this->t_idx] = 1;
+		this->reshape(this->counts);
+		readSliceInto(it, this->vec.data());
+		if (this->unpack_on_read) this->set_unpacked_missing_value();
+	}
+
+	void readBlock(size_t t_start, size_t t_count) override {
+		this->starts[this->t_idx] = t_start;
+		this->counts[this->t_idx] = t_count;
+		this->reshape(this->counts);
+		readBlockInto(t_start, t_count, this->vec.data());
+		if (this->unpack_on_read) this->set_unpacked_missing_value();
+	}
+
+	void readBlockInto(size_t t_start, size_t t_count, T* buffer) const override {
+		thread_local Hyperslab h; // (reused, so that steady-state reads do not allocate)
+		h.starts = this->starts;
+		h.counts = this->counts;
+		h.strides = this->strides;
+		h.starts[this->t_idx] = t_start;
+		h.counts[this->t_idx] = t_count;
+		read(h, buffer);
+	}
+
+	using GeoCube<T>::read;
+
+	/// @brief   read a hyperslab, with time indices on the joined axis (see GeoCube::read). The cube is not modified.
+	void read(const Hyperslab& h, T* buffer) const override {
+		if (h.strides[this->t_idx] != 1) throw std::runtime_error("MFGeoCube: strides along time are not supported");
+		if (this->lon_wraps(h.starts, h.counts) && h.strides[this->lon_idx] != 1) throw std::runtime_error("MFGeoCube: strides along a wrapped longitude range are not supported");
+		size_t t_start = h.starts[this->t_idx], t_count = h.counts[this->t_idx];
+
+		// memory layout of the output block, used to place each file's piece at the right location
+		thread_local std::vector<size_t> s, c;
+		thread_local std::vector<ptrdiff_t> imap;
+		s = h.starts;
+		c = h.counts;
+		size_t nd = c.size();
+		imap.assign(nd, 1);
+		for (int k=int(nd)-2; k>=0; --k) imap[k] = imap[k+1]*c[k+1];
+
+		size_t t = t_start;
+		while (t < t_start + t_count){
+			auto [f, local] = locate(t);
+			size_t n = std::min(t_start + t_count, file_offsets[f+1]) - t;
+
+			s[this->t_idx] = local;
+			c[this->t_idx] = n;
+
+			std::lock_guard<std::mutex> hlock(handles_mutex);
+			const netCDF::NcVar& var = file_var(f);
+			std::lock_guard<std::mutex> lock(netcdf_mutex(root_ncid(var.getParentGroup().getId())));
+			// (one read per period of a longitude range that wraps around)
+			this->for_each_lon_piece(h.starts[this->lon_idx], h.counts[this->lon_idx], [&](size_t start, size_t count, size_t offset){
+				s[this->lon_idx] = start;
+				c[this->lon_idx] = count;
+				FLARE_INSTRUMENT_SCOPE("getVar", this->io_label, n*(h.size()/std::max(t_count, size_t(1)))*count/std::max(h.counts[this->lon_idx], size_t(1))*sizeof(T), &c);
+				var.getVar(s, c, h.strides, imap, buffer + (t - t_start)*imap[this->t_idx] + offset*imap[this->lon_idx]);
+			});
+
+			t += n;
+		}
+
+		this->unpack_buffer(buffer, h.size());
+	}
+
+	void readSliceInto(size_t t_index, T* buffer) const override {
+		auto [f, local] = locate(t_index);
+		thread_local std::vector<size_t> s, c, joined;
+		s = this->starts;
+		c = this->counts;
+		s[this->t_idx] = local;
+		c[this->t_idx] = 1;
+		joined = s;
+		joined[this->t_idx] = t_index; // (cache keys use the index on the joined axis)
+
+		std::lock_guard<std::mutex> hlock(handles_mutex);
+		this->read_slice(file_var(f), s, c, buffer, &joined);
+	}
+
+	/// @brief           number of files currently open (excluding the first file, which is always open)
+	size_t nOpenFiles() const {
+		std::lock_guard<std::mutex> hlock(handles_mutex);
+		return handles.size();
+	}
+
+	protected:
+
+	// get the variable from file f, opening the file if necessary. Caller must hold handles_mutex.
+	const netCDF::NcVar& file_var(size_t f) const {
+		if (f == 0) return this->ncvar;
+
+		auto it = handles.find(f);
+		if (it != handles.end()){
+			handles_lru.remove(f);
+			handles_lru.push_front(f);
+			return it->second.var;
+		}
+
+		std::lock_guard<std::mutex> lock(netcdf_mutex());
+
+		// close least recently used files to respect the cap
+		while (!handles_lru.empty() && handles.size() >= std::max(max_open_files, size_t(1))){
+			handles.erase(handles_lru.back());  // NcFile closes on destruction
+			handles_lru.pop_back();
+		}
+
+		Handle h;
+		h.file = std::make_unique<NcFilePP>();
+		h.file->open(files[f], netCDF::NcFile::read);
+		h.var = h.file->getVar(this->ncvar.getName());
+		if (h.var.isNull()) throw std::runtime_error("MFGeoCube: variable " + this->ncvar.getName() + " not found in " + files[f]);
+
+		handles_lru.push_front(f);
+		return (handles[f] = std::move(h)).var;
+	}
+
+};
+
+} // namespace flare
+
+#endif
@@ -8,20 +8,132 @@
 #include <netcdf>
 #include <chrono>
 #include <cmath>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+#include <netcdf.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "utils.h"
+#include "meta_cache.h"
+#include "instrument.h"
 
 namespace flare{
 
+// ncid of the file that a (group) id belongs to: netCDF-4 group ids carry the group in the low 16 bits
+inline int root_ncid(int id){
+	return (id < 0)? id : (id & ~0xFFFF);
+}
+
+// netCDF-C (and HDF5 in its default build) is not thread safe. 
+// All data reads issued by flare are serialized through this lock, so that 
+// background readers (e.g. the prefetcher) can coexist with reads on the main thread.
+// If netCDF/HDF5 are built thread safe, define FLARE_NETCDF_THREADSAFE to get 
+// one lock per file (root ncid, see root_ncid) instead, so that different files can be read concurrently.
+inline std::mutex& netcdf_mutex(int ncid = -1){
+#ifdef FLARE_NETCDF_THREADSAFE
+	if (ncid >= 0){
+		static std::mutex map_mutex;
+		static std::map<int, std::unique_ptr<std::mutex>> file_mutexes;
+		std::lock_guard<std::mutex> lock(map_mutex);
+		auto& m = file_mutexes[ncid];
+		if (!m) m = std::make_unique<std::mutex>();
+		return *m;
+	}
+#else
+	(void)ncid;
+#endif
+	static std::mutex m;
+	return m;
+}
+
 
 class NcFilePP : public netCDF::NcFile {
 	public:
 	std::multimap <std::string, netCDF::NcVar> vars_map;     // variable name --> NcVar map (for data variables)
 	std::map      <std::string, netCDF::NcVar> coords_map;   // variable name --> NcVar map (for coordinate variables)
 	std::map      <std::string, std::string> coordunits_map;
-	std::map      <std::string, std::vector<double>> coordvalues_map;
+	std::map      <std::string, CoordArray> coordvalues_map; // (values shared with the metadata cache and cubes)
+	std::string path;  // path of the open file (if opened via open())
+	FileMode mode = read;
+
+	// Staging: open a read-only file from a copy of it in memory, so that all later reads (metadata,
+	// coordinates, blocks) are served at memory speed instead of issuing many small reads to the disk
+	// (which is slow on network file systems). Meant for small, repeatedly read files (masks, parameters, climatologies).
+	enum class Staging {
+		automatic,  // stage in RAM if the file is smaller than stage_threshold, else read from disk
+		none,       // read from disk
+		ram,        // read the whole file into memory with one sequential read
+		mmap        // map the file into memory (pages are read on first access, with read-ahead)
+	};
+	inline static size_t stage_threshold = 0;  // [bytes] size below which files are staged by Staging::automatic (0 = never)
+
+	private:
+	std::shared_ptr<void> image;   // in-memory image of a staged file (must outlive the netCDF handle)
+	size_t image_size = 0;
+
+	public:
+	~NcFilePP(){
+		try{ close(); }
+		catch(...){}
+	}
+
+	/// @brief   open a file. Files opened read-only are staged in memory if smaller than stage_threshold.
+	void open(const std::string& filePath, FileMode fMode){
+		open(filePath, fMode, Staging::automatic);
+	}
+
+	/// @brief   open a file. Files opened read-only can be staged in memory (see Staging); other modes ignore staging.
+	void open(const std::string& filePath, FileMode fMode, Staging staging){
+		if (fMode == read && staging == Staging::automatic){
+			if (stage_threshold == 0) staging = Staging::none;
+			else {
+				FileStamp stamp = FileStamp::of(filePath);
+				staging = (stamp.size > 0 && size_t(stamp.size) < stage_threshold)? Staging::ram : Staging::none;
+			}
+		}
+		if (fMode != read || staging == Staging::none){
+			if (!nullObject) close(); // (releases the image of a previously staged file)
+			netCDF::NcFile::open(filePath, fMode);
+		}
+		else open_staged(filePath, staging);
+		path = filePath;
+		mode = fMode;
+	}
+
+	/// @brief   open (or create) a file with the given format. Never staged.
+	void open(const std::string& filePath, FileMode fMode, FileFormat fFormat){
+		if (!nullObject) close();
+		netCDF::NcFile::open(filePath, fMode, fFormat);
+		path = filePath;
+		mode = fMode;
+	}
+
+	/// @brief   close the file (and release its in-memory image, if staged)
+	void close(){
+		netCDF::NcFile::close();
+		image.reset();
+		image_size = 0;
+	}
+
+	/// @brief   whether the file is served from memory
+	bool staged() const {
+		return bool(image);
+	}
+
+	/// @brief   size of the in-memory image of a staged file [bytes]
+	size_t stagedBytes() const {
+		return image_size;
+	}
 
 	inline void readMeta(){
+		FLARE_INSTRUMENT_SCOPE("NcFilePP::readMeta", path);
+		// (serialized with reads from other threads, see netcdf_mutex)
+		std::lock_guard<std::mutex> lock(netcdf_mutex(root_ncid(getId())));
+
 		// get all variable in the file in a name --> variable map
 		vars_map = this->getVars();
 		
@@ -36,7 +148,18 @@ class NcFilePP : public netCDF::NcFile {
 			vars_map.erase(p.first);
 		}
 
+		// values and units of coordinate vars: reuse them if this version of the file has been read before
+		// (only for files opened read-only, as others may change without their stamp changing)
+		FileStamp stamp = (path.empty() || mode != read)? FileStamp() : FileStamp::of(path);
+		auto cached = MetaCache::instance().find(stamp);
+		if (cached){
+			coordunits_map = cached->units;
+			for (auto& v : cached->values) coordvalues_map[v.first] = v.second;
+			return;
+		}
+
 		// read values and units for coordinate vars
+		auto meta = std::make_shared<CoordMeta>();
 		for (auto p : coords_map){
 			std::string s;
 			try{
@@ -48,11 +171,13 @@ class NcFilePP : public netCDF::NcFile {
 				coordunits_map[p.first] = "";
 			}
 
-			std::vector<double> coordvals(p.second.getDim(0).getSize());
-			p.second.getVar(coordvals.data());
+			auto coordvals = std::make_shared<std::vector<double>>(p.second.getDim(0).getSize());
+			p.second.getVar(coordvals->data());
 			coordvalues_map[p.first] = coordvals;
+			meta->values[p.first] = coordvals;
 		}
-
+		meta->units = coordunits_map;
+		MetaCache::instance().put(stamp, meta);
 	}
 
 	inline void printMeta(){
@@ -64,14 +189,58 @@ class NcFilePP : public netCDF::NcFile {
 		std::cout << "   coord values:\n";
 		for (auto p : coordvalues_map){
 			std::cout << "      " << p.first << ": ";
-			if (p.second.size() <= 6) std::cout << p.second;
+			auto& v = p.second;
+			if (v.size() <= 6) std::cout << v;
 			else{
-				std::cout << p.second.size() << " | " << p.second[0] << " " << p.second[1] << " " << p.second[2] << " ... " 
-				          << p.second[p.second.size()-3] << " " << p.second[p.second.size()-2] << " " << p.second[p.second.size()-1] << "\n";
+				std::cout << v.size() << " | " << v[0] << " " << v[1] << " " << v[2] << " ... " 
+				          << v[v.size()-3] << " " << v[v.size()-2] << " " << v[v.size()-1] << "\n";
 			}
 		}
 		std::cout << "~~\n";
 	}
+
+	private:
+	// load (or map) the file and open it with nc_open_mem
+	void open_staged(const std::string& filePath, Staging staging){
+		if (!nullObject) close();
+		FLARE_INSTRUMENT_SCOPE("NcFilePP::stage", filePath, size_t(std::max<int64_t>(FileStamp::of(filePath).size, 0)));
+
+		std::shared_ptr<void> img;
+		size_t n = 0;
+		if (staging == Staging::mmap){
+			int fd = ::open(filePath.c_str(), O_RDONLY);
+			if (fd < 0) throw std::runtime_error("NcFilePP: cannot open " + filePath);
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size == 0){
+				::close(fd);
+				throw std::runtime_error("NcFilePP: cannot stat " + filePath);
+			}
+			n = st.st_size;
+			// private, writable mapping: the file is never modified, even if the library touches the image
+			void* p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (p == MAP_FAILED) throw std::runtime_error("NcFilePP: cannot map " + filePath);
+			madvise(p, n, MADV_WILLNEED);
+			img = std::shared_ptr<void>(p, [n](void* q){ munmap(q, n); });
+		}
+		else {
+			std::ifstream fin(filePath, std::ios::binary | std::ios::ate);
+			if (!fin) throw std::runtime_error("NcFilePP: cannot open " + filePath);
+			n = fin.tellg();
+			auto buf = std::make_shared<std::vector<char>>(n);
+			fin.seekg(0);
+			if (!fin.read(buf->data(), n)) throw std::runtime_error("NcFilePP: cannot read " + filePath);
+			img = std::shared_ptr<void>(buf, buf->data());
+		}
+
+		int ncid;
+		int status = nc_open_mem(filePath.c_str(), NC_NOWRITE, n, img.get(), &ncid);
+		if (status != NC_NOERR) throw std::runtime_error("NcFilePP: cannot open " + filePath + " from memory: " + nc_strerror(status));
+		image = img;
+		image_size = n;
+		myId = ncid;
+		nullObject = false;
+	}
 };
 
 
@@ -0,0 +1,138 @@
+#ifndef FLARE_FLARE_POINT_SAMPLING_H
+#define FLARE_FLARE_POINT_SAMPLING_H
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include "axis_index.h"
+#include "utils.h"
+
+namespace flare{
+
+enum class Sampling { nearest, bilinear };
+
+/// @brief  Grid cells (lat index, lon index) and weights used to sample one point
+struct PointStencil {
+	int n = 0;
+	size_t ilat[4], ilon[4];
+	double w[4];
+};
+
+/// @brief    bracketing indices and interpolation fraction of v along axis x: v ~ (1-f)*x[i0] + f*x[i1].
+///           Values outside the axis are clamped to the end points.
+inline void bracket(const std::vector<double>& x, const AxisIndex& ax, double v, size_t& i0, size_t& i1, double& f){
+	size_t g = ax.count_before(x, v);
+	if (g == 0)        { i0 = i1 = 0;          f = 0; return; }
+	if (g >= x.size()) { i0 = i1 = x.size()-1; f = 0; return; }
+	i0 = g-1;
+	i1 = g;
+	f = (v - x[i0])/(x[i1] - x[i0]);
+}
+
+/// @brief    as bracket, on a periodic (longitude) axis covering 360 degrees: v is taken modulo 360, and
+///           values between the last and the first longitude are interpolated across the edge of the grid.
+inline void bracket_periodic(const std::vector<double>& x, const AxisIndex& ax, double v, size_t& i0, size_t& i1, double& f){
+	size_t n = x.size();
+	size_t ilo = (x.back() < x.front())? n-1 : 0, ihi = n-1-ilo;  // indices of the smallest and largest lon
+	double lo = x[ilo], hi = x[ihi];
+	v = lo + utils::positive_fmod(v - lo, 360);  // in [lo, lo+360)
+	if (v <= hi){
+		bracket(x, ax, v, i0, i1, f);
+		return;
+	}
+	i0 = ihi;
+	i1 = ilo;
+	f = (v - hi)/(lo + 360 - hi);
+}
+
+/// @brief    compute the sampling stencil of a point on a lat/lon grid
+/// @param lon_periodic   whether the lon axis covers the full circle, so that points near the dateline (or
+///                       given in the other lon convention) use the grid cells on both sides of the edge
+inline PointStencil make_stencil(double lat, double lon,
+                                 const std::vector<double>& lats, const AxisIndex& lat_ax,
+                                 const std::vector<double>& lons, const AxisIndex& lon_ax,
+                                 Sampling method, bool lon_periodic = false){
+	PointStencil s;
+	size_t a0, a1, b0, b1;
+	double fa, fb;
+	if (lon_periodic) bracket_periodic(lons, lon_ax, lon, b0, b1, fb);
+
+	if (method == Sampling::nearest){
+		s.n = 1;
+		s.ilat[0] = lat_ax.nearest(lats, lat);
+		s.ilon[0] = (lon_periodic)? ((fb <= 0.5)? b0 : b1) : lon_ax.nearest(lons, lon);
+		s.w[0] = 1;
+		return s;
+	}
+
+	bracket(lats, lat_ax, lat, a0, a1, fa);
+	if (!lon_periodic) bracket(lons, lon_ax, lon, b0, b1, fb);
+	size_t ia[4] = {a0, a0, a1, a1};
+	size_t ib[4] = {b0, b1, b0, b1};
+	double w[4]  = {(1-fa)*(1-fb), (1-fa)*fb, fa*(1-fb), fa*fb};
+	for (int k=0; k<4; ++k){
+		if (w[k] == 0) continue;
+		s.ilat[s.n] = ia[k];
+		s.ilon[s.n] = ib[k];
+		s.w[s.n] = w[k];
+		++s.n;
+	}
+	return s;
+}
+
+/// @brief  Plan for reading the grid cells needed by a set of point stencils, grouped into tiles
+///         (aligned to the storage chunks) so that each tile is read with a single hyperslab.
+struct PointReadPlan {
+	struct Tile {
+		size_t lat0, nlat, lon0, nlon;   // bounding box of the needed cells within the tile
+		std::vector<size_t> cells;       // ids of needed cells in this tile
+	};
+	std::vector<std::pair<size_t,size_t>> cells; // unique (lat, lon) cells, indexed by cell id
+	std::vector<std::vector<size_t>> point_cells; // for each point and stencil entry, the cell id
+	std::vector<Tile> tiles;
+
+	/// @param tile_lat, tile_lon   tile size (typically the chunk size along lat and lon)
+	PointReadPlan(const std::vector<PointStencil>& stencils, size_t tile_lat, size_t tile_lon){
+		tile_lat = std::max(tile_lat, size_t(1));
+		tile_lon = std::max(tile_lon, size_t(1));
+
+		std::map<std::pair<size_t,size_t>, size_t> cell_ids;
+		for (auto& s : stencils){
+			std::vector<size_t> ids;
+			for (int k=0; k<s.n; ++k){
+				auto key = std::make_pair(s.ilat[k], s.ilon[k]);
+				auto it = cell_ids.find(key);
+				if (it == cell_ids.end()){
+					it = cell_ids.emplace(key, cells.size()).first;
+					cells.push_back(key);
+				}
+				ids.push_back(it->second);
+			}
+			point_cells.push_back(ids);
+		}
+
+		// group cells by tile
+		std::map<std::pair<size_t,size_t>, size_t> tile_ids;
+		for (size_t c=0; c<cells.size(); ++c){
+			auto key = std::make_pair(cells[c].first/tile_lat, cells[c].second/tile_lon);
+			auto it = tile_ids.find(key);
+			if (it == tile_ids.end()){
+				it = tile_ids.emplace(key, tiles.size()).first;
+				tiles.push_back(Tile{cells[c].first, 1, cells[c].second, 1, {}});
+			}
+			Tile& t = tiles[it->second];
+			size_t lat1 = std::max(t.lat0 + t.nlat, cells[c].first + 1);
+			size_t lon1 = std::max(t.lon0 + t.nlon, cells[c].second + 1);
+			t.lat0 = std::min(t.lat0, cells[c].first);
+			t.lon0 = std::min(t.lon0, cells[c].second);
+			t.nlat = lat1 - t.lat0;
+			t.nlon = lon1 - t.lon0;
+			t.cells.push_back(c);
+		}
+	}
+};
+
+} // namespace flare
+
+#endif
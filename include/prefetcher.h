@@ -0,0 +1,107 @@
+#ifndef FLARE_FLARE_PREFETCHER_H
+#define FLARE_FLARE_PREFETCHER_H
+
+#include <future>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "geocube.h"
+
+namespace flare{
+
+/// @brief  Double-buffered reader around a GeoCube.
+///         After each read, the slice for the next distinct time index (predicted
+///         from the step size) is read into a back buffer on a background thread,
+///         so that the next call to read() finds its data ready.
+///         The prefetcher owns all reads on the cube while it is alive - do not
+///         call readBlock() or change the hyperslab of the cube directly.
+template <class T>
+class Prefetcher {
+	public:
+	GeoCube<T>& cube;
+	double step;            // expected increment in julian day between successive calls [days]
+	bool periodic;
+	bool centred_t;
+	int max_lookahead = 1000; // max number of steps to look ahead for a new index
+
+	private:
+	std::vector<T> back;              // buffer being filled in the background
+	long current_idx = -1;            // time index currently held in cube.vec
+	long back_idx = -1;               // time index being read into back buffer
+	long last_idx = -1;               // current_idx for which no next index was found within the lookahead
+	std::future<void> pending;
+
+	public:
+	Prefetcher(GeoCube<T>& _cube, double _step, bool _periodic, bool _centred_t)
+		: cube(_cube), step(_step), periodic(_periodic), centred_t(_centred_t) {}
+
+	~Prefetcher(){
+		// (a failed background read is reported by read(); it must not escape the destructor)
+		try{ wait(); }
+		catch(...){}
+	}
+
+	/// @brief             make the slice for julian_day available in cube.vec, and start prefetching the next one
+	/// @param julian_day  julian day for which to read data
+	/// @return            the time index that was read
+	size_t read(double julian_day){
+		long idx = cube.julian_to_index(julian_day, periodic, centred_t);
+
+		if (idx != current_idx){
+			wait();
+			if (idx == back_idx){
+				// prefetched data is ready: swap it in without copying
+				// and update the hyperslab and missing value as readBlock(julian_day, ...) does
+				cube.vec.swap(back);
+				if (cube.t_idx >= 0) cube.setIndices(cube.t_idx, idx, 1, cube.getStrides()[cube.t_idx]);
+				if constexpr (std::is_floating_point<T>::value){
+					if (cube.unpack_on_read) cube.missing_value = std::numeric_limits<T>::quiet_NaN();
+				}
+			}
+			else {
+				// misprediction (or first call): read synchronously
+				cube.readBlock(julian_day, periodic, centred_t);
+			}
+			current_idx = idx;
+			back_idx = -1;
+		}
+
+		// predict the next index that differs from the current one, and prefetch it
+		if (back_idx < 0 || back_idx == current_idx){
+			long next = predict_next(julian_day);
+			if (next >= 0 && next != current_idx) launch(next);
+		}
+
+		return idx;
+	}
+
+	/// @brief  block until any background read is complete
+	void wait(){
+		if (pending.valid()) pending.get();
+	}
+
+	private:
+
+	long predict_next(double julian_day){
+		if (current_idx == last_idx) return -1; // (searched already)
+		for (int k=1; k<=max_lookahead; ++k){
+			long next = cube.julian_to_index(julian_day + k*step, periodic, centred_t);
+			if (next != current_idx) return next;
+		}
+		last_idx = current_idx;
+		return -1; // index does not change within lookahead window (e.g. end of non-periodic data)
+	}
+
+	void launch(long next){
+		back.resize(cube.sliceSize());
+		back_idx = next;
+		pending = std::async(std::launch::async, [this, next](){
+			cube.readSliceInto(next, back.data());
+		});
+	}
+
+};
+
+} // namespace flare
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef FLARE_FLARE_READ_PLAN_H
+#define FLARE_FLARE_READ_PLAN_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <numeric>
+#include <functional>
+#include <algorithm>
+
+#include "utils.h"
+
+namespace flare{
+
+/// @brief  How a variable is stored in the file
+struct StorageLayout {
+	bool chunked = false;
+	std::vector<size_t> chunks;   // chunk shape (empty if contiguous)
+	bool shuffle = false;
+	bool deflate = false;
+	int deflate_level = 0;
+	std::string endianness = "native";
+	size_t elem_size = 0;         // bytes per element in the file
+
+	size_t chunk_bytes() const {
+		return std::accumulate(chunks.begin(), chunks.end(), size_t(1), std::multiplies<size_t>())*elem_size;
+	}
+
+	void print(std::string prefix = "") const {
+		std::cout << prefix << "storage = " << (chunked? "chunked" : "contiguous") << " (row-major, " << endianness << " endian)\n";
+		if (chunked) std::cout << prefix << "chunks = " << chunks;
+		std::cout << prefix << "compression = " << (deflate? "deflate (level " + std::to_string(deflate_level) + ")" : "none") << (shuffle? " + shuffle" : "") << "\n";
+	}
+};
+
+
+/// @brief  Access pattern used to size the chunk cache
+enum class AccessPattern {
+	time_slice,   // successive time slices over a spatial window (e.g. model time stepping)
+	time_series   // long time ranges over a small spatial window (e.g. point extraction)
+};
+
+
+/// @brief  A read of a hyperslab, split into chunk-aligned sub-reads, with the
+///         resulting I/O cost: how many bytes have to be decompressed from whole chunks
+///         vs how many bytes are delivered to the caller.
+struct ReadPlan {
+	std::vector<std::vector<size_t>> sub_starts, sub_counts; // sub-reads (split along dim 0, so that each is contiguous in memory)
+	std::vector<size_t> sub_offsets;                         // offset of each sub-read in the output buffer [elements]
+	size_t chunks_touched = 0;
+	size_t bytes_decompressed = 0;
+	size_t bytes_delivered = 0;
+
+	double efficiency() const {
+		return (bytes_decompressed > 0)? double(bytes_delivered)/bytes_decompressed : 1;
+	}
+
+	void print(std::string prefix = "") const {
+		std::cout << prefix << "Read plan > " << sub_starts.size() << " sub-read(s)\n";
+		for (size_t i=0; i<sub_starts.size(); ++i){
+			std::cout << prefix << "   start = " << sub_starts[i];
+			std::cout << prefix << "   count = " << sub_counts[i];
+		}
+		std::cout << prefix << "   chunks touched     = " << chunks_touched << "\n";
+		std::cout << prefix << "   bytes decompressed = " << bytes_decompressed << "\n";
+		std::cout << prefix << "   bytes delivered    = " << bytes_delivered << " (efficiency = " << efficiency()*100 << " %)\n";
+	}
+};
+
+
+/// @brief   number of chunks along each dimension touched by a hyperslab
+inline std::vector<size_t> chunks_touched(const StorageLayout& layout, const std::vector<size_t>& starts, const std::vector<size_t>& counts, const std::vector<ptrdiff_t>& strides){
+	std::vector<size_t> n(starts.size(), 1);
+	if (!layout.chunked) return n;
+	for (size_t d=0; d<starts.size(); ++d){
+		if (counts[d] == 0){ n[d] = 0; continue; }
+		size_t last = starts[d] + (counts[d]-1)*strides[d];
+		n[d] = last/layout.chunks[d] - starts[d]/layout.chunks[d] + 1;
+	}
+	return n;
+}
+
+
+/// @brief                   plan the read of a hyperslab
+/// @param max_read_bytes    split the read into chunk-aligned sub-reads along dim 0 of at most this size
+///                          (at least one chunk row per sub-read). 0 = do not split.
+inline ReadPlan make_read_plan(const StorageLayout& layout, const std::vector<size_t>& starts, const std::vector<size_t>& counts, const std::vector<ptrdiff_t>& strides, size_t elem_size_out, size_t max_read_bytes = 0){
+	ReadPlan plan;
+
+	size_t nelem = std::accumulate(counts.begin(), counts.end(), size_t(1), std::multiplies<size_t>());
+	plan.bytes_delivered = nelem*elem_size_out;
+
+	std::vector<size_t> nch = chunks_touched(layout, starts, counts, strides);
+	plan.chunks_touched = std::accumulate(nch.begin(), nch.end(), size_t(1), std::multiplies<size_t>());
+	plan.bytes_decompressed = (layout.chunked)? plan.chunks_touched*layout.chunk_bytes() : nelem*layout.elem_size;
+
+	// elements per unit of dim 0 in the output
+	size_t row = (counts.empty() || counts[0] == 0)? 0 : nelem/counts[0];
+
+	bool can_split = layout.chunked && max_read_bytes > 0 && !counts.empty() && strides[0] == 1 && counts[0] > 1;
+	if (!can_split || plan.bytes_delivered <= max_read_bytes){
+		plan.sub_starts.push_back(starts);
+		plan.sub_counts.push_back(counts);
+		plan.sub_offsets.push_back(0);
+		return plan;
+	}
+
+	// split along dim 0 at chunk boundaries
+	size_t ch = layout.chunks[0];
+	size_t rows_per_read = std::max(max_read_bytes/(row*elem_size_out*ch), size_t(1))*ch; // whole chunk rows
+	size_t i = starts[0], end = starts[0] + counts[0];
+	while (i < end){
+		size_t next = std::min((i/ch)*ch + rows_per_read, end);   // first piece may start mid-chunk, but ends on a boundary
+		std::vector<size_t> s = starts, c = counts;
+		s[0] = i;
+		c[0] = next - i;
+		plan.sub_starts.push_back(s);
+		plan.sub_counts.push_back(c);
+		plan.sub_offsets.push_back((i - starts[0])*row);
+		i = next;
+	}
+	return plan;
+}
+
+
+/// @brief  smallest prime >= n (used for the number of chunk cache slots)
+inline size_t next_prime(size_t n){
+	auto is_prime = [](size_t k){
+		if (k < 2) return false;
+		for (size_t d=2; d*d<=k; ++d) if (k%d == 0) return false;
+		return true;
+	};
+	while (!is_prime(n)) ++n;
+	return n;
+}
+
+} // namespace flare
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef FLARE_FLARE_READER_GROUP_H
+#define FLARE_FLARE_READER_GROUP_H
+
+#include <vector>
+#include "geocube.h"
+#include "thread_pool.h"
+
+namespace flare{
+
+/// @brief  Reads a set of GeoCubes (e.g. all forcing variables of a timestep) concurrently on a thread pool.
+///         Each cube keeps its own hyperslab and data, so cubes can be read in parallel. The netCDF
+///         library calls themselves are protected by netcdf_mutex(): with the default (non thread safe)
+///         netCDF build they are serialized and only the work around them (unpacking, cache lookups,
+///         copies) overlaps. If netCDF/HDF5 are built thread safe, compile with -DFLARE_NETCDF_THREADSAFE
+///         to lock per file, so that cubes from different files are read concurrently.
+template <class T>
+class ReaderGroup {
+	public:
+	std::vector<GeoCube<T>*> cubes;
+
+	private:
+	ThreadPool pool;
+
+	public:
+	explicit ReaderGroup(size_t nthreads = std::thread::hardware_concurrency()) : pool(nthreads) {}
+
+	ReaderGroup(std::vector<GeoCube<T>*> _cubes, size_t nthreads = std::thread::hardware_concurrency())
+		: cubes(_cubes), pool(nthreads) {}
+
+	void add(GeoCube<T>& cube){
+		cubes.push_back(&cube);
+	}
+
+	size_t nthreads() const {
+		return pool.size();
+	}
+
+	/// @brief  read the slice for julian_day into every cube
+	void readBlock(double julian_day, bool periodic, bool centred_t){
+		run([=](GeoCube<T>* c){ c->readBlock(julian_day, periodic, centred_t); });
+	}
+
+	/// @brief  read the block [unlim_start, unlim_start+unlim_count) into every cube
+	void readBlock(size_t unlim_start, size_t unlim_count){
+		run([=](GeoCube<T>* c){ c->readBlock(unlim_start, unlim_count); });
+	}
+
+	private:
+	template <class F>
+	void run(F f){
+		std::vector<std::future<void>> futs;
+		futs.reserve(cubes.size());
+		for (auto c : cubes) futs.push_back(pool.submit([f, c](){ f(c); }));
+		// wait for all reads, then rethrow the first error (if any)
+		std::exception_ptr err;
+		for (auto& fut : futs){
+			try{ fut.get(); }
+			catch(...){ if (!err) err = std::current_exception(); }
+		}
+		if (err) std::rethrow_exception(err);
+	}
+};
+
+} // namespace flare
+
+#endif
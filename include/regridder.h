@@ -0,0 +1,292 @@
+#ifndef FLARE_FLARE_REGRIDDER_H
+#define FLARE_FLARE_REGRIDDER_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "geocube.h"
+#include "cube_view.h"
+#include "point_sampling.h"
+#include "thread_pool.h"
+
+namespace flare{
+
+enum class RegridMethod {
+	bilinear,     // interpolate between the 4 surrounding source points
+	conservative  // area-weighted average of the overlapping source cells (first order)
+};
+
+
+/// @brief  Sparse matrix in compressed sparse row (CSR) format.
+///         Row i holds the weights of destination point i: entries [row_ptr[i], row_ptr[i+1]) of col and w.
+struct SparseWeights {
+	size_t nrows = 0, ncols = 0;
+	std::vector<size_t>   row_ptr{0};
+	std::vector<uint32_t> col;
+	std::vector<double>   w;
+
+	size_t nnz() const {
+		return w.size();
+	}
+
+	void save(const std::string& path) const {
+		std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+		if (!fout) throw std::runtime_error("SparseWeights: cannot open " + path + " for writing");
+		uint64_t hdr[4] = {0x57524552414c46ull /* "FLAREWR" */, nrows, ncols, nnz()};
+		fout.write((const char*)hdr, sizeof(hdr));
+		fout.write((const char*)row_ptr.data(), row_ptr.size()*sizeof(size_t));
+		fout.write((const char*)col.data(), col.size()*sizeof(uint32_t));
+		fout.write((const char*)w.data(), w.size()*sizeof(double));
+		if (!fout) throw std::runtime_error("SparseWeights: error writing " + path);
+	}
+
+	void load(const std::string& path){
+		std::ifstream fin(path, std::ios::binary);
+		if (!fin) throw std::runtime_error("SparseWeights: cannot open " + path);
+		uint64_t hdr[4];
+		fin.read((char*)hdr, sizeof(hdr));
+		if (!fin || hdr[0] != 0x57524552414c46ull) throw std::runtime_error("SparseWeights: " + path + " is not a weights file");
+		nrows = hdr[1];
+		ncols = hdr[2];
+		row_ptr.resize(nrows+1);
+		col.resize(hdr[3]);
+		w.resize(hdr[3]);
+		fin.read((char*)row_ptr.data(), row_ptr.size()*sizeof(size_t));
+		fin.read((char*)col.data(), col.size()*sizeof(uint32_t));
+		fin.read((char*)w.data(), w.size()*sizeof(double));
+		if (!fin) throw std::runtime_error("SparseWeights: " + path + " is truncated");
+	}
+};
+
+
+/// @brief  Regrids 2D lat/lon fields from a source to a destination rectilinear grid (regular or
+///         not, e.g. Gaussian latitudes). Remapping weights are computed once (or loaded from disk),
+///         and applied to each field as a sparse matrix-vector product.
+///         Longitudes are treated as periodic if the source grid spans the globe.
+///         Destination fields are in (lat, lon) order. Missing source values are skipped, and the
+///         weights of the remaining values renormalized; points without any valid source value are missing.
+class Regridder {
+	public:
+	RegridMethod method;
+	std::vector<double> src_lats, src_lons, dst_lats, dst_lons;
+	bool src_lat_major = true;    // whether source fields are in (lat, lon) order (or (lon, lat))
+	SparseWeights weights;
+
+	Regridder(){}
+
+	/// @param lat_major   whether source fields are in (lat, lon) order (or (lon, lat))
+	Regridder(const std::vector<double>& _src_lats, const std::vector<double>& _src_lons,
+	          const std::vector<double>& _dst_lats, const std::vector<double>& _dst_lons,
+	          RegridMethod _method, bool lat_major = true)
+		: method(_method), src_lats(_src_lats), src_lons(_src_lons), dst_lats(_dst_lats), dst_lons(_dst_lons), src_lat_major(lat_major) {
+		if (method == RegridMethod::bilinear) compute_bilinear();
+		else                                  compute_conservative();
+	}
+
+	/// @brief   regrid from the current (trimmed) lat/lon window of a cube
+	template <class T>
+	Regridder(const GeoCube<T>& src, const std::vector<double>& _dst_lats, const std::vector<double>& _dst_lons, RegridMethod _method)
+		: Regridder(src.coords_trimmed[src.lat_idx], src.coords_trimmed[src.lon_idx], _dst_lats, _dst_lons, _method, src.lat_idx < src.lon_idx) {}
+
+	/// @brief   regrid a single field: dst = W*src. dst must have space for dst_lats.size()*dst_lons.size() values.
+	/// @param pool   if given, rows are processed in parallel on the pool
+	template <class T>
+	void apply(const T* src, T* dst, T missing_value, ThreadPool* pool = nullptr) const {
+		auto rows = [&](size_t b, size_t e){
+			for (size_t i=b; i<e; ++i){
+				double sum = 0, wsum = 0;
+				for (size_t k=weights.row_ptr[i]; k<weights.row_ptr[i+1]; ++k){
+					T v = src[weights.col[k]];
+					if (v == missing_value || v != v) continue;
+					sum  += weights.w[k]*v;
+					wsum += weights.w[k];
+				}
+				dst[i] = (wsum > 0)? T(sum/wsum) : missing_value;
+			}
+		};
+		if (pool) pool->parallel_for(weights.nrows, rows);
+		else      rows(0, weights.nrows);
+	}
+
+	/// @brief   regrid the current contents of a cube (which must hold a single lat/lon slice)
+	template <class T>
+	Tensor<T> apply(const GeoCube<T>& src, ThreadPool* pool = nullptr) const {
+		if (src.vec.size() != weights.ncols) throw std::runtime_error("Regridder: cube data does not match the source grid (" + std::to_string(src.vec.size()) + " vs " + std::to_string(weights.ncols) + " values)");
+		Tensor<T> out;
+		out.resize(std::vector<size_t>{dst_lats.size(), dst_lons.size()});
+		out.missing_value = src.missing_value;
+		apply(src.vec.data(), out.vec.data(), src.missing_value, pool);
+		return out;
+	}
+
+	/// @brief   regrid a single lat/lon slice given as a view (e.g. one time step of a loaded block). 
+	///          The view is used in place if it is contiguous.
+	template <class U>
+	Tensor<std::remove_const_t<U>> apply(const CubeView<U>& src, ThreadPool* pool = nullptr) const {
+		using V = std::remove_const_t<U>;
+		if (src.size() != weights.ncols || src.shape[src.lat_idx]*src.shape[src.lon_idx] != weights.ncols || (src.lat_idx < src.lon_idx) != src_lat_major)
+			throw std::runtime_error("Regridder: view does not match the source grid");
+		thread_local std::vector<V> buffer;
+		Tensor<V> out;
+		out.resize(std::vector<size_t>{dst_lats.size(), dst_lons.size()});
+		out.missing_value = src.missing_value;
+		apply(src.packed(buffer), out.vec.data(), src.missing_value, pool);
+		return out;
+	}
+
+	void save(const std::string& path) const {
+		weights.save(path);
+	}
+
+	/// @brief   load weights computed earlier for the same grids and method
+	void load(const std::string& path){
+		weights.load(path);
+		if (weights.nrows != dst_lats.size()*dst_lons.size() || weights.ncols != src_lats.size()*src_lons.size())
+			throw std::runtime_error("Regridder: weights in " + path + " do not match the grids");
+	}
+
+	private:
+
+	size_t src_index(size_t ilat, size_t ilon) const {
+		return (src_lat_major)? ilat*src_lons.size() + ilon : ilon*src_lats.size() + ilat;
+	}
+
+	bool src_global() const {
+		size_t n = src_lons.size();
+		if (n < 2) return false;
+		double dlon = std::fabs(src_lons[n-1] - src_lons[0])/(n-1);
+		return std::fabs(std::fabs(src_lons[n-1] - src_lons[0]) + dlon - 360) < 0.5*dlon;
+	}
+
+	void add_row(std::vector<std::pair<size_t,double>>& entries){
+		std::sort(entries.begin(), entries.end());
+		double wsum = 0;
+		for (auto& e : entries) wsum += e.second;
+		for (size_t k=0; k<entries.size(); ++k){
+			if (entries[k].second <= 0) continue;
+			if (!weights.col.empty() && weights.w.size() > weights.row_ptr.back() && weights.col.back() == entries[k].first){
+				weights.w.back() += entries[k].second/wsum;  // duplicate column (e.g. wrap-around)
+				continue;
+			}
+			weights.col.push_back(entries[k].first);
+			weights.w.push_back(entries[k].second/wsum);
+		}
+		weights.row_ptr.push_back(weights.w.size());
+	}
+
+	void init_weights(){
+		weights = SparseWeights();
+		weights.nrows = dst_lats.size()*dst_lons.size();
+		weights.ncols = src_lats.size()*src_lons.size();
+		weights.row_ptr.reserve(weights.nrows+1);
+	}
+
+	void compute_bilinear(){
+		init_weights();
+		AxisIndex lat_ax(src_lats), lon_ax(src_lons);
+		bool global = src_global();
+		size_t nlon = src_lons.size();
+		double lon0 = std::min(src_lons.front(), src_lons.back());
+
+		// bracketing source lons of each destination lon (separable)
+		std::vector<size_t> b0(dst_lons.size()), b1(dst_lons.size());
+		std::vector<double> fb(dst_lons.size());
+		for (size_t j=0; j<dst_lons.size(); ++j){
+			double lon = dst_lons[j];
+			if (global){
+				lon = lon0 + utils::positive_fmod(lon - lon0, 360);
+				double lon_last = std::max(src_lons.front(), src_lons.back());
+				if (lon > lon_last){ // between the last and the first source lon
+					size_t ilast = (src_lons.back() > src_lons.front())? nlon-1 : 0;
+					b0[j] = ilast;
+					b1[j] = nlon-1-ilast;
+					fb[j] = (lon - lon_last)/(lon0 + 360 - lon_last);
+					continue;
+				}
+			}
+			bracket(src_lons, lon_ax, lon, b0[j], b1[j], fb[j]);
+		}
+
+		std::vector<std::pair<size_t,double>> entries;
+		for (size_t i=0; i<dst_lats.size(); ++i){
+			size_t a0, a1;
+			double fa;
+			bracket(src_lats, lat_ax, dst_lats[i], a0, a1, fa);
+			for (size_t j=0; j<dst_lons.size(); ++j){
+				entries.clear();
+				entries.emplace_back(src_index(a0, b0[j]), (1-fa)*(1-fb[j]));
+				entries.emplace_back(src_index(a0, b1[j]), (1-fa)*fb[j]);
+				entries.emplace_back(src_index(a1, b0[j]), fa*(1-fb[j]));
+				entries.emplace_back(src_index(a1, b1[j]), fa*fb[j]);
+				add_row(entries);
+			}
+		}
+	}
+
+	// cell edges from cell centres (half way between centres; end cells symmetric about their centre)
+	static std::vector<double> cell_edges(const std::vector<double>& x){
+		size_t n = x.size();
+		std::vector<double> e(n+1);
+		if (n == 1){ e[0] = x[0]-0.5; e[1] = x[0]+0.5; return e; }
+		e[0] = x[0] - (x[1]-x[0])/2;
+		for (size_t i=1; i<n; ++i) e[i] = (x[i-1]+x[i])/2;
+		e[n] = x[n-1] + (x[n-1]-x[n-2])/2;
+		return e;
+	}
+
+	// overlaps between destination and source cells along one axis: for each destination cell, (source cell, overlap)
+	// lat overlaps are measured in sin(lat), so that products of lat and lon overlaps are proportional to area.
+	// periodic: also match cells shifted by +/-360 (so that e.g. [0,360) and [-180,180) grids overlap)
+	static std::vector<std::vector<std::pair<size_t,double>>> overlaps(const std::vector<double>& src, const std::vector<double>& dst, bool is_lat, bool periodic){
+		auto es = cell_edges(src), ed = cell_edges(dst);
+		auto measure = [is_lat](double lo, double hi){
+			if (!is_lat) return hi - lo;
+			lo = std::clamp(lo, -90.0, 90.0);
+			hi = std::clamp(hi, -90.0, 90.0);
+			return std::sin(hi*M_PI/180) - std::sin(lo*M_PI/180);
+		};
+
+		std::vector<std::vector<std::pair<size_t,double>>> ov(dst.size());
+		for (size_t i=0; i<dst.size(); ++i){
+			double d0 = std::min(ed[i], ed[i+1]), d1 = std::max(ed[i], ed[i+1]);
+			for (size_t k=0; k<src.size(); ++k){
+				double s0 = std::min(es[k], es[k+1]), s1 = std::max(es[k], es[k+1]);
+				double total = 0;
+				for (int shift = (periodic? -1 : 0); shift <= (periodic? 1 : 0); ++shift){
+					double lo = std::max(d0, s0 + 360*shift), hi = std::min(d1, s1 + 360*shift);
+					if (hi > lo) total += measure(lo - 360*shift, hi - 360*shift);
+				}
+				if (total > 0) ov[i].emplace_back(k, total);
+			}
+		}
+		return ov;
+	}
+
+	void compute_conservative(){
+		init_weights();
+		auto lat_ov = overlaps(src_lats, dst_lats, true, false);
+		auto lon_ov = overlaps(src_lons, dst_lons, false, src_global());
+
+		std::vector<std::pair<size_t,double>> entries;
+		for (size_t i=0; i<dst_lats.size(); ++i){
+			for (size_t j=0; j<dst_lons.size(); ++j){
+				entries.clear();
+				for (auto& a : lat_ov[i]){
+					for (auto& b : lon_ov[j]){
+						entries.emplace_back(src_index(a.first, b.first), a.second*b.second);
+					}
+				}
+				add_row(entries);
+			}
+		}
+	}
+};
+
+} // namespace flare
+
+#endif
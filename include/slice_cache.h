@@ -0,0 +1,130 @@
+#ifndef FLARE_FLARE_SLICE_CACHE_H
+#define FLARE_FLARE_SLICE_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <iostream>
+#include <algorithm>
+
+namespace flare{
+
+/// @brief  Bounded LRU cache of data slices, keyed by a string that identifies
+///         the variable and the hyperslab (see GeoCube::cacheKey()).
+///         A single cache can be shared by several GeoCubes, in which case
+///         the memory budget applies to all of them together.
+template <class T>
+class SliceCache {
+	public:
+	struct Stats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes_used = 0;
+		size_t budget = 0;
+	};
+
+	private:
+	struct Entry {
+		std::string key;
+		std::vector<T> data;
+	};
+
+	std::list<Entry> lru;    // most recently used entry at the front
+	std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+	size_t budget;           // memory budget [bytes]
+	size_t bytes_used = 0;
+	size_t hits = 0, misses = 0, evictions = 0;
+	mutable std::mutex mtx;
+
+	public:
+	/// @param budget_bytes  maximum memory used by cached data [bytes]
+	explicit SliceCache(size_t budget_bytes = 256*1024*1024) : budget(budget_bytes) {}
+
+	/// @brief       copy cached data for key into out, if present
+	/// @return      true on hit, false on miss
+	bool get(const std::string& key, T* out, size_t n){
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = index.find(key);
+		if (it == index.end() || it->second->data.size() != n){
+			++misses;
+			return false;
+		}
+		lru.splice(lru.begin(), lru, it->second); // mark as most recently used
+		std::copy(it->second->data.begin(), it->second->data.end(), out);
+		++hits;
+		return true;
+	}
+
+	/// @brief       insert a copy of data under key, evicting least recently used entries to stay within budget
+	void put(const std::string& key, const T* data, size_t n){
+		size_t bytes = n*sizeof(T);
+		if (bytes > budget) return;  // slice larger than the whole cache, don't bother
+
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = index.find(key);
+		if (it != index.end()){
+			bytes_used -= it->second->data.size()*sizeof(T);
+			lru.erase(it->second);
+			index.erase(it);
+		}
+
+		while (bytes_used + bytes > budget && !lru.empty()) evict_last();
+
+		lru.push_front(Entry{key, std::vector<T>(data, data+n)});
+		index[key] = lru.begin();
+		bytes_used += bytes;
+	}
+
+	/// @brief  change the memory budget, evicting entries if necessary
+	void setBudget(size_t budget_bytes){
+		std::lock_guard<std::mutex> lock(mtx);
+		budget = budget_bytes;
+		while (bytes_used > budget && !lru.empty()) evict_last();
+	}
+
+	void clear(){
+		std::lock_guard<std::mutex> lock(mtx);
+		lru.clear();
+		index.clear();
+		bytes_used = 0;
+	}
+
+	Stats stats() const {
+		std::lock_guard<std::mutex> lock(mtx);
+		Stats s;
+		s.hits = hits;
+		s.misses = misses;
+		s.evictions = evictions;
+		s.entries = lru.size();
+		s.bytes_used = bytes_used;
+		s.budget = budget;
+		return s;
+	}
+
+	void print_stats() const {
+		Stats s = stats();
+		double hit_rate = (s.hits+s.misses > 0)? double(s.hits)/(s.hits+s.misses) : 0;
+		std::cout << "Slice cache >\n";
+		std::cout << "   hits = " << s.hits << ", misses = " << s.misses << " (hit rate = " << hit_rate*100 << " %)\n";
+		std::cout << "   evictions = " << s.evictions << "\n";
+		std::cout << "   entries = " << s.entries << "\n";
+		std::cout << "   memory used = " << s.bytes_used/1024.0/1024.0 << " / " << s.budget/1024.0/1024.0 << " MB\n";
+	}
+
+	private:
+	void evict_last(){
+		bytes_used -= lru.back().data.size()*sizeof(T);
+		index.erase(lru.back().key);
+		lru.pop_back();
+		++evictions;
+	}
+
+};
+
+} // namespace flare
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef FLARE_FLARE_TEMPORAL_REDUCER_H
+#define FLARE_FLARE_TEMPORAL_REDUCER_H
+
+#include <map>
+#include <vector>
+#include <limits>
+#include <functional>
+#include "geocube.h"
+
+namespace flare{
+
+/// @brief  Calendar periods by which time steps are grouped
+enum class Period {
+	all,            // one group for the whole time range (e.g. long-term mean)
+	year,           // one group per year (annual means/sums)
+	month,          // one group per calendar month of each year (monthly means)
+	month_of_year,  // one group per month, pooled over years (monthly climatology)
+	day_of_year     // one group per calendar day (month and day), pooled over years (daily climatology)
+};
+
+/// @brief  group key of a date for a given period. Days of year are keyed as mmdd, so that a calendar day
+///         falls in the same group in leap and non-leap years (Feb 29 has a group of its own).
+///         y = CE year, m = 1-12, d = 1-31 (in the calendar of the time axis).
+inline long period_key(int y, int m, int d, Period period){
+	switch (period){
+		case Period::year:          return y;
+		case Period::month:         return y*100 + m;   // yyyymm
+		case Period::month_of_year: return m;
+		case Period::day_of_year:   return m*100 + d;   // mmdd
+		default:                    return 0;
+	}
+}
+
+inline long period_key(const std::tm& date, Period period){
+	return period_key(date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, period);
+}
+
+
+/// @brief  Running (Welford) mean, variance, sum, min and max per grid cell
+struct RunningStats {
+	std::vector<double>   mean, m2, sum, min, max;
+	std::vector<uint32_t> n;
+
+	explicit RunningStats(size_t ncells = 0)
+		: mean(ncells, 0), m2(ncells, 0), sum(ncells, 0),
+		  min(ncells,  std::numeric_limits<double>::infinity()),
+		  max(ncells, -std::numeric_limits<double>::infinity()),
+		  n(ncells, 0) {}
+
+	void add(size_t cell, double v){
+		++n[cell];
+		double delta = v - mean[cell];
+		mean[cell] += delta/n[cell];
+		m2[cell]   += delta*(v - mean[cell]);
+		sum[cell]  += v;
+		min[cell] = std::min(min[cell], v);
+		max[cell] = std::max(max[cell], v);
+	}
+};
+
+
+/// @brief  Computes statistics over the time axis of a GeoCube out-of-core: the time axis is
+///         read in blocks (by default one chunk long), and running statistics are kept per grid
+///         cell and per calendar period. Missing values are skipped.
+///         For Period::year and Period::month, set on_close to stream the results: each group is handed
+///         to on_close as soon as the time axis leaves it (and by finish() for the last one), then freed,
+///         so that peak memory is one block plus one accumulator. Time must then be increasing.
+///         Without on_close, all groups are kept until the end.
+template <class T>
+class TemporalReducer {
+	public:
+	/// called with the key of a closed group; the statistics of that group (mean(key), ...) can be read
+	/// from the reducer during the call, and are discarded after it
+	using GroupFn = std::function<void(long key, const TemporalReducer<T>& reducer)>;
+
+	Period period;
+	std::vector<size_t> cell_dims;       // dims of the output fields (a single time slice of the cube)
+	std::map<long, RunningStats> groups; // period key --> stats (see period_key())
+	GroupFn on_close;
+
+	explicit TemporalReducer(Period _period = Period::all, GroupFn _on_close = nullptr) : period(_period), on_close(_on_close) {}
+
+	/// @brief            accumulate time steps [t_start, t_start+t_count) of the cube, over its current spatial window.
+	///                   Note that the time hyperslab of the cube is changed. Can be called repeatedly, e.g. for several files.
+	/// @param block_len  number of time steps read at once (0 = chunk length along time, or 32 for contiguous data)
+	void accumulate(GeoCube<T>& cube, size_t t_start, size_t t_count, size_t block_len = 0){
+		if (cube.t_idx < 0) throw std::runtime_error("TemporalReducer: variable does not have a time dimension");
+		if (block_len == 0) block_len = (cube.storage.chunked)? cube.storage.chunks[cube.t_idx] : 32;
+
+		std::vector<size_t> sc = cube.sliceCounts();
+		if (cell_dims.empty()) cell_dims = sc;
+		else if (cell_dims != sc) throw std::runtime_error("TemporalReducer: spatial window differs from previous calls");
+
+		size_t ncells = std::accumulate(sc.begin(), sc.end(), size_t(1), std::multiplies<size_t>());
+
+		for (size_t b = t_start; b < t_start + t_count; b += block_len){
+			size_t nt = std::min(block_len, t_start + t_count - b);
+			cube.setIndices(cube.t_idx, b, nt);
+			cube.readBlock(b, nt);
+
+			// layout of the block: (outer, time, inner)
+			size_t inner = 1;
+			for (size_t d = cube.t_idx+1; d < sc.size(); ++d) inner *= sc[d];
+			size_t outer = ncells/inner;
+
+			T mv = cube.missing_value;
+			for (size_t k=0; k<nt; ++k){
+				// (dates in the calendar of the time axis, so that e.g. a 360_day year has 12 months of 30 days)
+				int y, m, d, h, mi;
+				double sec;
+				calendar_days_to_ymdhms(cube.getCalendar(), cube.getCalendarBase() + cube.coords_trimmed[cube.t_idx][b+k], y, m, d, h, mi, sec);
+				long key = period_key(y, m, d, period);
+				auto it = groups.find(key);
+				if (it == groups.end()){
+					if (streaming()) close_groups();
+					it = groups.emplace(key, RunningStats(ncells)).first;
+				}
+				RunningStats& acc = it->second;
+
+				for (size_t o=0; o<outer; ++o){
+					const T* p = cube.vec.data() + (o*nt + k)*inner;
+					for (size_t i=0; i<inner; ++i){
+						T v = p[i];
+						if (v == mv || v != v) continue; // skip missing (and NaN) values
+						acc.add(o*inner + i, v);
+					}
+				}
+			}
+		}
+	}
+
+	/// @brief    hand the remaining groups to on_close (if set) and free them. Call after the last accumulate().
+	void finish(){
+		if (on_close) close_groups();
+	}
+
+	/// @brief    keys of all groups held, in ascending order
+	std::vector<long> keys() const {
+		std::vector<long> k;
+		for (auto& g : groups) k.push_back(g.first);
+		return k;
+	}
+
+	Tensor<double> mean(long key = 0) const {
+		return field(key, [](const RunningStats& s, size_t c){ return s.mean[c]; });
+	}
+
+	Tensor<double> sum(long key = 0) const {
+		return field(key, [](const RunningStats& s, size_t c){ return s.sum[c]; });
+	}
+
+	Tensor<double> min(long key = 0) const {
+		return field(key, [](const RunningStats& s, size_t c){ return s.min[c]; });
+	}
+
+	Tensor<double> max(long key = 0) const {
+		return field(key, [](const RunningStats& s, size_t c){ return s.max[c]; });
+	}
+
+	/// @param ddof   delta degrees of freedom (0 = population variance, 1 = sample variance)
+	Tensor<double> variance(long key = 0, int ddof = 0) const {
+		return field(key, [ddof](const RunningStats& s, size_t c){
+			return (s.n[c] > uint32_t(ddof))? s.m2[c]/(s.n[c]-ddof) : std::numeric_limits<double>::quiet_NaN();
+		});
+	}
+
+	/// @brief    number of valid (non-missing) values per cell
+	Tensor<double> count(long key = 0) const {
+		auto& s = stats(key);
+		Tensor<double> out;
+		out.resize(cell_dims);
+		for (size_t c=0; c<s.n.size(); ++c) out.vec[c] = s.n[c];
+		return out;
+	}
+
+	private:
+	// whether groups are handed out as they close (only calendar periods that do not recur)
+	bool streaming() const {
+		return on_close && (period == Period::year || period == Period::month);
+	}
+
+	void close_groups(){
+		for (auto& g : groups) on_close(g.first, *this);
+		groups.clear();
+	}
+
+	const RunningStats& stats(long key) const {
+		auto it = groups.find(key);
+		if (it == groups.end()) throw std::runtime_error("TemporalReducer: no data for group " + std::to_string(key));
+		return it->second;
+	}
+
+	// output field with NaN where there were no valid values
+	template <class F>
+	Tensor<double> field(long key, F f) const {
+		auto& s = stats(key);
+		Tensor<double> out;
+		out.resize(cell_dims);
+		out.missing_value = std::numeric_limits<double>::quiet_NaN();
+		for (size_t c=0; c<s.n.size(); ++c) out.vec[c] = (s.n[c] > 0)? f(s, c) : out.missing_value;
+		return out;
+	}
+};
+
+} // namespace flare
+
+#endif
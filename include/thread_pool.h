@@ -0,0 +1,95 @@
+#ifndef FLARE_FLARE_THREAD_POOL_H
+#define FLARE_FLARE_THREAD_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <vector>
+#include <algorithm>
+
+namespace flare{
+
+/// @brief  Minimal fixed-size thread pool
+class ThreadPool {
+	private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool stopping = false;
+
+	public:
+	explicit ThreadPool(size_t nthreads = std::thread::hardware_concurrency()){
+		nthreads = std::max(nthreads, size_t(1));
+		for (size_t i=0; i<nthreads; ++i){
+			workers.emplace_back([this](){
+				while (true){
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(mtx);
+						cv.wait(lock, [this](){ return stopping || !tasks.empty(); });
+						if (stopping && tasks.empty()) return;
+						task = std::move(tasks.front());
+						tasks.pop();
+					}
+					task();
+				}
+			});
+		}
+	}
+
+	~ThreadPool(){
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stopping = true;
+		}
+		cv.notify_all();
+		for (auto& w : workers) w.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t size() const {
+		return workers.size();
+	}
+
+	/// @brief    queue a task. The returned future rethrows any exception thrown by the task.
+	template <class F>
+	std::future<void> submit(F f){
+		auto task = std::make_shared<std::packaged_task<void()>>(std::move(f));
+		std::future<void> fut = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			tasks.emplace([task](){ (*task)(); });
+		}
+		cv.notify_one();
+		return fut;
+	}
+
+	/// @brief    run f(begin, end) over [0, n) split into contiguous ranges, one per worker, and wait for completion.
+	///           All ranges finish (so f may capture the caller's locals by reference) before the first exception, if any, is rethrown.
+	template <class F>
+	void parallel_for(size_t n, F f){
+		size_t nchunks = std::min(n, workers.size());
+		std::vector<std::future<void>> futs;
+		for (size_t c=0; c<nchunks; ++c){
+			size_t b = n*c/nchunks, e = n*(c+1)/nchunks;
+			futs.push_back(submit([f, b, e](){ f(b, e); }));
+		}
+		std::exception_ptr err;
+		for (auto& fut : futs){
+			try{ fut.get(); }
+			catch(...){ if (!err) err = std::current_exception(); }
+		}
+		if (err) std::rethrow_exception(err);
+	}
+};
+
+} // namespace flare
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef FLARE_FLARE_TIME_INTERPOLATOR_H
+#define FLARE_FLARE_TIME_INTERPOLATOR_H
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include "geocube.h"
+
+namespace flare{
+
+/// @brief  Reads a GeoCube at arbitrary julian days by linear interpolation between the
+///         two time slices that bracket the requested time.
+///         The two bracketing slices are kept resident; when the requested time moves past
+///         a slice boundary, only the slice that has become stale is re-read. Each call
+///         therefore costs one blend plus at most one (usually zero) read.
+///         With periodic extension, the last slice is interpolated towards the first one
+///         (one period later). Without it, values are held constant beyond the ends of the data.
+///         A missing value in either slice gives a missing value in the output (unless the
+///         other slice has zero weight).
+///         The interpolator owns all reads on the cube while it is alive - do not call
+///         readBlock() or change the hyperslab of the cube directly.
+template <class T>
+class TimeInterpolator {
+	public:
+	GeoCube<T>& cube;
+	bool periodic;
+	bool centred_t;
+
+	private:
+	std::vector<T> slots[2];   // resident slices
+	long held[2] = {-1, -1};   // time index held in each slot
+	AxisIndex t_axis;          // index on the trimmed time axis
+
+	public:
+	/// @param centred_t  whether t at index represents centre of interval (or start of interval).
+	///                   Values are interpolated between interval centres.
+	TimeInterpolator(GeoCube<T>& _cube, bool _periodic, bool _centred_t)
+		: cube(_cube), periodic(_periodic), centred_t(_centred_t) {}
+
+	/// @brief             interpolate the data to julian_day, into cube.vec
+	/// @return            weight of the later of the two bracketing slices (0 <= f < 1)
+	double read(double julian_day){
+		size_t i0, i1;
+		double f;
+		bracket_time(julian_day, i0, i1, f);
+
+		// refill only the slot(s) that do not hold a needed slice
+		const T* a = slice(i0, i1);
+		const T* b = slice(i1, i0);
+
+		size_t n = cube.sliceSize();
+		if (cube.vec.size() != n){
+			cube.resize(cube.sliceCounts());
+			if constexpr (std::is_floating_point<T>::value){
+				if (cube.unpack_on_read) cube.missing_value = std::numeric_limits<T>::quiet_NaN(); // as in readBlock()
+			}
+		}
+
+		blend(a, b, T(f), cube.missing_value, cube.vec.data(), n);
+		return f;
+	}
+
+	/// @brief  bracketing time indices of julian_day, and the weight f of i1: v = (1-f)*v[i0] + f*v[i1]
+	void bracket_time(double julian_day, size_t& i0, size_t& i1, double& f){
+		if (cube.t_idx < 0) throw std::runtime_error("TimeInterpolator: variable does not have a time dimension");
+		auto& tvec = cube.coords_trimmed[cube.t_idx];
+		size_t nt = tvec.size();
+		double tstep = cube.getTstep();
+
+		// time in file units, relative to interval centres
+		double t = cube.julian_to_t(julian_day);
+		if (!centred_t) t -= tstep/2;
+
+		double DeltaT = tvec[nt-1] - tvec[0] + tstep;
+		if (periodic) t = tvec[0] + utils::positive_fmod(t - tvec[0], DeltaT);
+
+		// index of the last time value <= t
+		if (!t_axis.fits(tvec)) t_axis = AxisIndex(tvec);
+		long k = long(t_axis.count_before_eq(tvec, t)) - 1;
+		if (k < 0){                       // before the first slice (only if not periodic)
+			i0 = i1 = 0; f = 0; return;
+		}
+		i0 = k;
+		if (i0 < nt-1){
+			i1 = i0 + 1;
+			f = (t - tvec[i0])/(tvec[i1] - tvec[i0]);
+		}
+		else if (periodic && nt > 1){     // wrap around to the first slice, one period later
+			i1 = 0;
+			f = (t - tvec[i0])/(tvec[0] + DeltaT - tvec[i0]);
+		}
+		else {                            // beyond the last slice
+			i1 = i0; f = 0;
+		}
+		f = std::clamp(f, 0.0, 1.0);
+	}
+
+	private:
+
+	// data of slice idx, keeping the slice 'keep' resident if it is already held
+	const T* slice(size_t idx, size_t keep){
+		for (int s=0; s<2; ++s) if (held[s] == long(idx)) return slots[s].data();
+		int s = (held[0] == long(keep) && long(keep) != held[1])? 1 : 0;
+		slots[s].resize(cube.sliceSize());
+		cube.readSliceInto(idx, slots[s].data());
+		held[s] = idx;
+		return slots[s].data();
+	}
+
+	// out = (1-f)*a + f*b, in a single (auto-vectorized) pass
+	static void blend(const T* __restrict a, const T* __restrict b, T f, T mv, T* __restrict out, size_t n){
+		if (f == 0){
+			std::copy(a, a+n, out);
+			return;
+		}
+		for (size_t i=0; i<n; ++i){
+			T x = a[i], y = b[i];
+			out[i] = (x == mv || y == mv)? mv : x + f*(y - x);
+		}
+	}
+};
+
+} // namespace flare
+
+#endif
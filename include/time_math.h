@@ -5,6 +5,11 @@
 #include <iostream>
 #include <chrono>
 #include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
 
 // Note: tm format:
 // year = years OVER 1900. So add 1900 to get CE year
@@ -110,12 +115,381 @@ inline std::tm julian_to_date(double julian_date){
 	return result;
 }
 
+// ~~ Batch conversions ~~
+// Array versions of date_to_julian / julian_to_date on columns of (y, m, d, h, min, s), with
+// y = CE year, m = 1-12, d = 1-31. The loops use only integer division by constants and no
+// branches, so that the compiler can vectorize them.
+
+// julian days --> (y, m, d, h, min, s)
+inline void julian_to_ymdhms(const double* __restrict julian, size_t n, int* __restrict year, int* __restrict month, int* __restrict day, int* __restrict hour, int* __restrict minute, double* __restrict second){
+	for (size_t i=0; i<n; ++i){
+		double gday = julian[i] - 1721119.5;
+		int g = int(gday);
+		g -= (double(g) > gday);                       // floor (std::floor prevents vectorization)
+		double gfloor = g;
+
+		// day in yyyy, mm, dd (as in julian_to_date, with the year estimate computed in double, which is exact here)
+		int y = int((10000.0*gfloor + 14780)/3652425);
+		int ddd = g - (365*y + y/4 - y/100 + y/400);
+		int neg = ddd >> 31;                           // -1 if the estimate overshot, else 0
+		y += neg;
+		ddd = g - (365*y + y/4 - y/100 + y/400);
+		int mi = (52 + 100*ddd)/3060;
+		year[i]  = y + (mi + 2)/12;
+		month[i] = (mi + 2)%12 + 1;
+		day[i]   = ddd - (mi*306 + 5)/10 + 1;
+
+		// time in hh, mm, ss
+		double secs = (gday - gfloor)*86400;
+		int h = int(secs/3600);
+		int m = int((secs - h*3600)/60);
+		hour[i]   = h;
+		minute[i] = m;
+		second[i] = secs - h*3600 - m*60;
+	}
+}
+
+// (y, m, d, h, min, s) --> julian days
+inline void ymdhms_to_julian(const int* __restrict year, const int* __restrict month, const int* __restrict day, const int* __restrict hour, const int* __restrict minute, const double* __restrict second, size_t n, double* __restrict julian){
+	for (size_t i=0; i<n; ++i){
+		double d_int = _ymd2gday(year[i], month[i], day[i]);
+		double d_frac = (hour[i]*3600.0 + minute[i]*60.0 + second[i])*(1.0/86400);
+		julian[i] = d_int + d_frac + 1721119.5;
+	}
+}
+
+/// @brief  Dates as columns (structure of arrays), for batch conversions
+struct DateColumns {
+	std::vector<int> year, month, day, hour, minute;
+	std::vector<double> second;
+
+	size_t size() const {
+		return year.size();
+	}
+
+	void resize(size_t n){
+		year.resize(n); month.resize(n); day.resize(n);
+		hour.resize(n); minute.resize(n); second.resize(n);
+	}
+};
+
+inline DateColumns julian_to_dates(const std::vector<double>& julian){
+	DateColumns c;
+	c.resize(julian.size());
+	julian_to_ymdhms(julian.data(), julian.size(), c.year.data(), c.month.data(), c.day.data(), c.hour.data(), c.minute.data(), c.second.data());
+	return c;
+}
+
+inline std::vector<double> dates_to_julian(const DateColumns& c){
+	std::vector<double> julian(c.size());
+	ymdhms_to_julian(c.year.data(), c.month.data(), c.day.data(), c.hour.data(), c.minute.data(), c.second.data(), c.size(), julian.data());
+	return julian;
+}
+
+
+// ~~ Fast ISO-8601 parsing ~~
+
+// parse an integer with optional sign, advancing p. Returns false if there are no digits.
+inline bool _parse_int(const char*& p, const char* end, int& v){
+	bool neg = false;
+	if (p < end && (*p == '-' || *p == '+')){ neg = (*p == '-'); ++p; }
+	const char* start = p;
+	v = 0;
+	while (p < end && *p >= '0' && *p <= '9') v = v*10 + (*p++ - '0');
+	if (neg) v = -v;
+	return p > start;
+}
+
+/// @brief    parse an ISO-8601-like date-time without streams: "Y-M-D", optionally followed by
+///           (' ' or 'T') "h:m" or "h:m:s[.fff]", and optionally by 'Z', " UTC"/" GMT", or a "+hh:mm"/"-hh:mm"
+///           offset (which is applied, i.e. the result is in UTC). Fields do not need to be zero-padded
+///           (e.g. CF units like "days since 1-1-1 0:0:0").
+/// @return   false if the string is not of this form
+inline bool parse_iso8601(const std::string& str, int& year, int& month, int& day, int& hour, int& minute, double& second){
+	const char* p = str.data();
+	const char* end = p + str.size();
+	while (p < end && *p == ' ') ++p;
+
+	hour = minute = 0;
+	second = 0;
+	if (!_parse_int(p, end, year)  || p >= end || *p++ != '-') return false;
+	if (!_parse_int(p, end, month) || p >= end || *p++ != '-') return false;
+	if (!_parse_int(p, end, day)) return false;
+	if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+	if (p < end && (*p == 'T' || *p == ' ') && p+1 < end && p[1] >= '0' && p[1] <= '9'){
+		++p;
+		if (!_parse_int(p, end, hour) || p >= end || *p++ != ':' || !_parse_int(p, end, minute)) return false;
+		if (p < end && *p == ':'){
+			++p;
+			int isec;
+			if (!_parse_int(p, end, isec)) return false;
+			second = isec;
+			if (p < end && *p == '.'){
+				++p;
+				double f = 0.1;
+				while (p < end && *p >= '0' && *p <= '9'){ second += f*(*p++ - '0'); f *= 0.1; }
+			}
+		}
+	}
+
+	// zone
+	while (p < end && *p == ' ') ++p;
+	if (p < end && (*p == '+' || *p == '-')){
+		int sign = (*p++ == '-')? -1 : 1;
+		int oh, om = 0;
+		if (!_parse_int(p, end, oh)) return false;
+		if (p < end && *p == ':'){ ++p; if (!_parse_int(p, end, om)) return false; }
+		minute -= sign*(oh*60 + om); // to UTC (may leave minute out of range, which the julian day conversion handles)
+	}
+	else if (p < end && *p == 'Z') ++p;
+	else if (end - p >= 3 && (std::string(p, 3) == "UTC" || std::string(p, 3) == "GMT")) p += 3;
+
+	while (p < end && *p == ' ') ++p;
+	return p == end;
+}
+
+/// @brief   julian day of an ISO-8601 date-time string (see parse_iso8601). Throws if the string cannot be parsed.
+inline double iso8601_to_julian(const std::string& str){
+	int y, m, d, h, mi;
+	double s;
+	if (!parse_iso8601(str, y, m, d, h, mi, s)) throw std::runtime_error("Could not parse date-time string: " + str);
+	double j;
+	ymdhms_to_julian(&y, &m, &d, &h, &mi, &s, 1, &j);
+	return j;
+}
+
+// ~~ Calendars ~~
+// CF calendars. All calendars use the Gregorian month names and lengths, except that noleap has no
+// Feb 29, all_leap always has Feb 29, and day_360 has 12 months of 30 days.
+// Model time is always in (Gregorian) julian days. Data in another calendar is indexed by its own
+// day count ("calendar days"), and dates are mapped between calendars by year, month and day, with the
+// day clamped to the length of the month in the target calendar (e.g. Gregorian Feb 29 --> noleap Feb 28,
+// Gregorian Mar 31 --> 360_day Mar 30, 360_day Feb 30 --> Gregorian Feb 28/29).
+
+enum class Calendar { gregorian, noleap, all_leap, day_360 };
+
+/// @brief   calendar from a CF calendar attribute (standard, gregorian, proleptic_gregorian, noleap, 365_day,
+///          all_leap, 366_day, 360_day). Throws for other calendars. Note that dates before 1582-10-15 are
+///          always treated as proleptic Gregorian.
+inline Calendar calendar_from_string(std::string s){
+	std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return std::tolower(c); });
+	if (s == "" || s == "standard" || s == "gregorian" || s == "proleptic_gregorian") return Calendar::gregorian;
+	if (s == "noleap" || s == "365_day") return Calendar::noleap;
+	if (s == "all_leap" || s == "366_day") return Calendar::all_leap;
+	if (s == "360_day") return Calendar::day_360;
+	throw std::runtime_error("Unsupported calendar: " + s);
+}
+
+inline std::string calendar_name(Calendar c){
+	switch (c){
+		case Calendar::noleap:   return "noleap";
+		case Calendar::all_leap: return "all_leap";
+		case Calendar::day_360:  return "360_day";
+		default:                 return "standard";
+	}
+}
+
+// floor(a/b) for b > 0
+inline int _floor_div(int a, int b){
+	int q = a/b;
+	return q - (a - q*b < 0);
+}
+
+// Calendar arithmetic on whole days: days since the calendar's epoch <--> (y, m, d), in constant time.
+// Each calendar is specialized at compile time; with_calendar() selects one at runtime.
+template <Calendar C> struct CalendarTraits;
+
+template <> struct CalendarTraits<Calendar::gregorian> {
+	static constexpr double days_per_year = 365.2425;
+
+	static int days_in_month(int y, int m){
+		static const int dim[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+		return dim[m-1] + (m == 2 && isLeapYear(y));
+	}
+
+	static int ymd_to_days(int y, int m, int d){
+		return _ymd2gday(y, m, d);
+	}
+
+	// inverse of _ymd2gday (as in julian_to_date)
+	static void days_to_ymd(int g, int& y, int& m, int& d){
+		y = int((10000*(long long int)g + 14780)/3652425);
+		int ddd = g - (365*y + y/4 - y/100 + y/400);
+		if (ddd < 0){
+			--y;
+			ddd = g - (365*y + y/4 - y/100 + y/400);
+		}
+		int mi = (52 + 100*ddd)/3060;
+		y = y + (mi + 2)/12;
+		m = (mi + 2)%12 + 1;
+		d = ddd - (mi*306 + 5)/10 + 1;
+	}
+};
+
+// calendars with years of fixed length (365 or 366 days). Days are counted from 01-Mar-0000 as in
+// _ymd2gday, so that Feb (the only month whose length differs) is the last month of the year.
+template <int YearDays>
+struct FixedYearCalendar {
+	static constexpr double days_per_year = YearDays;
+
+	static int days_in_month(int, int m){
+		static const int dim[12] = {31, YearDays-337, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+		return dim[m-1];
+	}
+
+	static int ymd_to_days(int y, int m, int d){
+		m = (m+9)%12;
+		y = y - m/10;
+		return YearDays*y + (m*306 + 5)/10 + (d-1);
+	}
+
+	static void days_to_ymd(int g, int& y, int& m, int& d){
+		y = _floor_div(g, YearDays);
+		int ddd = g - YearDays*y;
+		int mi = (52 + 100*ddd)/3060;
+		y = y + (mi + 2)/12;
+		m = (mi + 2)%12 + 1;
+		d = ddd - (mi*306 + 5)/10 + 1;
+	}
+};
+
+template <> struct CalendarTraits<Calendar::noleap>   : FixedYearCalendar<365> {};
+template <> struct CalendarTraits<Calendar::all_leap> : FixedYearCalendar<366> {};
+
+template <> struct CalendarTraits<Calendar::day_360> {
+	static constexpr double days_per_year = 360;
+
+	static int days_in_month(int, int){
+		return 30;
+	}
+
+	static int ymd_to_days(int y, int m, int d){
+		return 360*y + 30*(m-1) + (d-1);
+	}
+
+	static void days_to_ymd(int g, int& y, int& m, int& d){
+		y = _floor_div(g, 360);
+		int r = g - 360*y;
+		m = r/30 + 1;
+		d = r%30 + 1;
+	}
+};
+
+/// @brief   call f(CalendarTraits<c>()) with the traits of the calendar c
+template <class F>
+auto with_calendar(Calendar c, F&& f){
+	switch (c){
+		case Calendar::noleap:   return f(CalendarTraits<Calendar::noleap>());
+		case Calendar::all_leap: return f(CalendarTraits<Calendar::all_leap>());
+		case Calendar::day_360:  return f(CalendarTraits<Calendar::day_360>());
+		default:                 return f(CalendarTraits<Calendar::gregorian>());
+	}
+}
+
+inline double calendar_days_per_year(Calendar c){
+	return with_calendar(c, [](auto cal){ return decltype(cal)::days_per_year; });
+}
+
+/// @brief   days since the epoch of calendar c of a date in that calendar (y = CE year, m = 1-12, d = 1-31)
+inline double calendar_days(Calendar c, int y, int m, int d, int h = 0, int mi = 0, double s = 0){
+	double d_int = with_calendar(c, [&](auto cal){ return cal.ymd_to_days(y, m, d); });
+	return d_int + (h*3600.0 + mi*60.0 + s)*(1.0/86400);
+}
+
+inline double date_to_calendar_days(Calendar c, std::tm t){
+	return calendar_days(c, t.tm_year+1900, t.tm_mon+1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+}
+
+/// @brief   date in calendar c of a number of days since the calendar's epoch
+inline void calendar_days_to_ymdhms(Calendar c, double days, int& y, int& m, int& d, int& h, int& mi, double& s){
+	double dfloor = std::floor(days);
+	with_calendar(c, [&](auto cal){ cal.days_to_ymd(int(dfloor), y, m, d); });
+	double secs = (days - dfloor)*86400;
+	h = int(secs/3600);
+	mi = int((secs - h*3600)/60);
+	s = secs - h*3600 - mi*60;
+}
+
+// julian day --> calendar days, and back, with whole-day calendar arithmetic in the traits Cal
+template <class Cal>
+inline double _julian_to_calendar_days(Cal cal, double j){
+	double gday = j - 1721119.5;
+	double gfloor = std::floor(gday);
+	int y, m, d;
+	CalendarTraits<Calendar::gregorian>::days_to_ymd(int(gfloor), y, m, d);
+	d = std::min(d, cal.days_in_month(y, m));
+	return cal.ymd_to_days(y, m, d) + (gday - gfloor);
+}
+
+template <class Cal>
+inline double _calendar_days_to_julian(Cal cal, double days){
+	double dfloor = std::floor(days);
+	int y, m, d;
+	cal.days_to_ymd(int(dfloor), y, m, d);
+	d = std::min(d, CalendarTraits<Calendar::gregorian>::days_in_month(y, m));
+	return _ymd2gday(y, m, d) + (days - dfloor) + 1721119.5;
+}
+
+/// @brief   calendar days (in calendar c) of the same date and time as julian day j
+inline double julian_to_calendar_days(Calendar c, double j){
+	if (c == Calendar::gregorian) return j - 1721119.5;
+	return with_calendar(c, [&](auto cal){ return _julian_to_calendar_days(cal, j); });
+}
+
+/// @brief   batch version of julian_to_calendar_days (the calendar is selected once for all n values)
+inline void julian_to_calendar_days(Calendar c, const double* julian, size_t n, double* days){
+	with_calendar(c, [&](auto cal){
+		for (size_t i=0; i<n; ++i) days[i] = _julian_to_calendar_days(cal, julian[i]);
+	});
+}
+
+/// @brief   julian day of the same date and time as a number of days in calendar c
+inline double calendar_days_to_julian(Calendar c, double days){
+	if (c == Calendar::gregorian) return days + 1721119.5;
+	return with_calendar(c, [&](auto cal){ return _calendar_days_to_julian(cal, days); });
+}
+
+/// @brief   julian day j --> days since a base date, in calendar c. The base is given both as a julian day and
+///          in calendar days, so that the Gregorian case is a plain difference.
+inline double julian_to_days_since(Calendar c, double j, double julian_base, double calendar_base){
+	if (c == Calendar::gregorian) return j - julian_base;
+	return julian_to_calendar_days(c, j) - calendar_base;
+}
+
+/// @brief   inverse of julian_to_days_since
+inline double days_since_to_julian(Calendar c, double t, double julian_base, double calendar_base){
+	if (c == Calendar::gregorian) return t + julian_base;
+	return calendar_days_to_julian(c, t + calendar_base);
+}
+
+/// @brief   calendar days of the date (y, m, d) plus a (possibly fractional or negative) number of months.
+///          Whole months are added to the month (with d clamped to the length of the resulting month),
+///          and the fraction is a fraction of the length of the resulting month.
+inline double calendar_add_months(Calendar c, int y, int m, int d, double months){
+	double kfloor = std::floor(months);
+	int mm = (m-1) + int(kfloor);
+	y += _floor_div(mm, 12);
+	m = mm - 12*_floor_div(mm, 12) + 1;
+	return with_calendar(c, [&](auto cal){
+		int dim = cal.days_in_month(y, m);
+		return cal.ymd_to_days(y, m, std::min(d, dim)) + (months - kfloor)*dim;
+	});
+}
+
 inline std::string julian_to_datestring(double j){
 	return date_to_string(julian_to_date(j));
 }
 
 inline double datestring_to_julian(std::string datestring){
-	return date_to_julian(string_to_date(datestring));
+	int y, m, d, h, mi;
+	double sec;
+	if (parse_iso8601(datestring, y, m, d, h, mi, sec)){
+		double j;
+		ymdhms_to_julian(&y, &m, &d, &h, &mi, &sec, 1, &j);
+		return j;
+	}
+	return date_to_julian(string_to_date(datestring)); // other formats
 }
 
 } // namespace flare
@@ -0,0 +1,176 @@
+#ifndef FLARE_FLARE_UNPACK_H
+#define FLARE_FLARE_UNPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Kernels to unpack netCDF data stored with scale_factor/add_offset:
+//     out = (in == fill)? NaN : in*scale + offset
+// Conversion, scaling and fill replacement are fused into a single pass.
+// AVX-512 and AVX2 versions are used when the compiler targets them (e.g. -march=native),
+// with a scalar loop for the remainder and for other targets/types. When the target has FMA, all
+// versions (including the remainder) compute in*scale + offset with a single rounding, so that
+// results do not depend on the vector width or the position of a value in the array.
+
+namespace flare{
+
+/// @brief          unpack n packed values from in to out
+/// @param fill     packed value marking missing data (ignored if has_fill is false)
+template <class P, class T>
+void unpack(const P* in, T* out, size_t n, T scale, T offset, P fill, bool has_fill){
+	static_assert(std::is_floating_point<T>::value, "unpack: output type must be floating point");
+	const T nan = std::numeric_limits<T>::quiet_NaN();
+	if (has_fill){
+		for (size_t i=0; i<n; ++i) out[i] = (in[i] == fill)? nan : T(in[i])*scale + offset;
+	}
+	else{
+		for (size_t i=0; i<n; ++i) out[i] = T(in[i])*scale + offset;
+	}
+}
+
+/// @brief          unpack n values in place (for data already converted to T, e.g. by netCDF)
+template <class T>
+void unpack_inplace(T* data, size_t n, T scale, T offset, T fill, bool has_fill){
+	unpack<T,T>(data, data, n, scale, offset, fill, has_fill);
+}
+
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+
+namespace simd{
+
+// x*s + o, fused if the target has FMA (as in the vector kernels)
+inline float madd(float x, float s, float o){
+#ifdef __FMA__
+	return std::fma(x, s, o);
+#else
+	return x*s + o;
+#endif
+}
+
+#ifdef __AVX512F__
+inline __m512 unpack16(__m512i wide, __m512 vs, __m512 vo, __m512i vfill, bool has_fill){
+	__m512 r = _mm512_fmadd_ps(_mm512_cvtepi32_ps(wide), vs, vo);
+	if (has_fill) r = _mm512_mask_blend_ps(_mm512_cmpeq_epi32_mask(wide, vfill), r, _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+	return r;
+}
+#endif
+
+#ifdef __AVX2__
+inline __m256 unpack8(__m256i wide, __m256 vs, __m256 vo, __m256i vfill, bool has_fill){
+#ifdef __FMA__
+	__m256 r = _mm256_fmadd_ps(_mm256_cvtepi32_ps(wide), vs, vo);
+#else
+	__m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(wide), vs), vo);
+#endif
+	if (has_fill) r = _mm256_blendv_ps(r, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()), _mm256_castsi256_ps(_mm256_cmpeq_epi32(wide, vfill)));
+	return r;
+}
+#endif
+
+} // namespace simd
+
+
+template <>
+inline void unpack<int16_t, float>(const int16_t* in, float* out, size_t n, float scale, float offset, int16_t fill, bool has_fill){
+	size_t i = 0;
+#ifdef __AVX512F__
+	{
+		__m512 vs = _mm512_set1_ps(scale), vo = _mm512_set1_ps(offset);
+		__m512i vfill = _mm512_set1_epi32(fill);
+		for (; i+16 <= n; i += 16){
+			__m512i wide = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(in+i)));
+			_mm512_storeu_ps(out+i, simd::unpack16(wide, vs, vo, vfill, has_fill));
+		}
+	}
+#endif
+#ifdef __AVX2__
+	{
+		__m256 vs = _mm256_set1_ps(scale), vo = _mm256_set1_ps(offset);
+		__m256i vfill = _mm256_set1_epi32(fill);
+		for (; i+8 <= n; i += 8){
+			__m256i wide = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in+i)));
+			_mm256_storeu_ps(out+i, simd::unpack8(wide, vs, vo, vfill, has_fill));
+		}
+	}
+#endif
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	for (; i<n; ++i) out[i] = (has_fill && in[i] == fill)? nan : simd::madd(float(in[i]), scale, offset);
+}
+
+
+template <>
+inline void unpack<int8_t, float>(const int8_t* in, float* out, size_t n, float scale, float offset, int8_t fill, bool has_fill){
+	size_t i = 0;
+#ifdef __AVX512F__
+	{
+		__m512 vs = _mm512_set1_ps(scale), vo = _mm512_set1_ps(offset);
+		__m512i vfill = _mm512_set1_epi32(fill);
+		for (; i+16 <= n; i += 16){
+			__m512i wide = _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(in+i)));
+			_mm512_storeu_ps(out+i, simd::unpack16(wide, vs, vo, vfill, has_fill));
+		}
+	}
+#endif
+#ifdef __AVX2__
+	{
+		__m256 vs = _mm256_set1_ps(scale), vo = _mm256_set1_ps(offset);
+		__m256i vfill = _mm256_set1_epi32(fill);
+		for (; i+8 <= n; i += 8){
+			__m256i wide = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(in+i)));
+			_mm256_storeu_ps(out+i, simd::unpack8(wide, vs, vo, vfill, has_fill));
+		}
+	}
+#endif
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	for (; i<n; ++i) out[i] = (has_fill && in[i] == fill)? nan : simd::madd(float(in[i]), scale, offset);
+}
+
+
+template <>
+inline void unpack<float, float>(const float* in, float* out, size_t n, float scale, float offset, float fill, bool has_fill){
+	size_t i = 0;
+#ifdef __AVX512F__
+	{
+		__m512 vs = _mm512_set1_ps(scale), vo = _mm512_set1_ps(offset), vfill = _mm512_set1_ps(fill);
+		__m512 vnan = _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN());
+		for (; i+16 <= n; i += 16){
+			__m512 x = _mm512_loadu_ps(in+i);
+			__m512 r = _mm512_fmadd_ps(x, vs, vo);
+			if (has_fill) r = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, vfill, _CMP_EQ_OQ), r, vnan);
+			_mm512_storeu_ps(out+i, r);
+		}
+	}
+#endif
+#ifdef __AVX2__
+	{
+		__m256 vs = _mm256_set1_ps(scale), vo = _mm256_set1_ps(offset), vfill = _mm256_set1_ps(fill);
+		__m256 vnan = _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+		for (; i+8 <= n; i += 8){
+			__m256 x = _mm256_loadu_ps(in+i);
+#ifdef __FMA__
+			__m256 r = _mm256_fmadd_ps(x, vs, vo);
+#else
+			__m256 r = _mm256_add_ps(_mm256_mul_ps(x, vs), vo);
+#endif
+			if (has_fill) r = _mm256_blendv_ps(r, vnan, _mm256_cmp_ps(x, vfill, _CMP_EQ_OQ));
+			_mm256_storeu_ps(out+i, r);
+		}
+	}
+#endif
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	for (; i<n; ++i) out[i] = (has_fill && in[i] == fill)? nan : simd::madd(in[i], scale, offset);
+}
+
+#endif // __AVX2__ || __AVX512F__
+
+} // namespace flare
+
+#endif
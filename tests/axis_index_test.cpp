@@ -0,0 +1,69 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include "../include/axis_index.h"
+using namespace std;
+
+// reference implementations by linear scan
+size_t count_before_ref(const vector<double>& x, double v, bool desc){
+	size_t c = 0;
+	for (auto xi : x) if (desc? xi > v : xi < v) ++c;
+	return c;
+}
+
+size_t count_before_eq_ref(const vector<double>& x, double v, bool desc){
+	size_t c = 0;
+	for (auto xi : x) if (desc? xi >= v : xi <= v) ++c;
+	return c;
+}
+
+int main(){
+	mt19937 rng(1);
+	uniform_real_distribution<double> unif(-200, 200);
+
+	for (int desc=0; desc<2; ++desc){
+		for (int irregular=0; irregular<2; ++irregular){
+			// 0.5 deg longitude axis, optionally with one perturbed point
+			vector<double> x;
+			for (int i=0; i<720; ++i) x.push_back(-179.75 + 0.5*i + ((irregular && i==300)? 0.2 : 0));
+			if (desc) reverse(x.begin(), x.end());
+
+			flare::AxisIndex ax(x);
+			cout << "descending = " << ax.descending << ", regular = " << ax.regular << "\n";
+			if (ax.regular == bool(irregular) || ax.descending != bool(desc)){
+				cout << "FAILED: axis not classified correctly\n";
+				return 1;
+			}
+
+			for (int k=0; k<100000; ++k){
+				// query exact coordinate values as well as random ones
+				double v = (k%3 == 0)? x[rng()%x.size()] : unif(rng);
+				if (ax.count_before(x, v) != count_before_ref(x, v, desc) || 
+				    ax.count_before_eq(x, v) != count_before_eq_ref(x, v, desc)){
+					cout << "FAILED: lookup mismatch for v = " << v << "\n";
+					return 1;
+				}
+				size_t nn = ax.nearest(x, v);
+				for (auto xi : x){
+					if (fabs(xi-v) < fabs(x[nn]-v)){
+						cout << "FAILED: nearest mismatch for v = " << v << "\n";
+						return 1;
+					}
+				}
+			}
+
+			// a stale index (built for another vector) must still give correct results
+			vector<double> y(x.rbegin(), x.rend());
+			double v = 10.1;
+			if (ax.count_before(y, v) != count_before_ref(y, v, !desc)){
+				cout << "FAILED: lookup on mismatched vector\n";
+				return 1;
+			}
+		}
+	}
+
+	cout << "-----------------\n";
+	cout << "All tests PASSED!\n";
+
+	return 0;
+}
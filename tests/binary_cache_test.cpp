@@ -0,0 +1,101 @@
+#include <cstring>
+#include <functional>
+#include "flare.h"
+
+// Check that slices of an exported binary cache are identical to those read from the netcdf file
+int main(){
+
+	flare::NcFilePP in_file;
+	in_file.open("tests/data/gpp.2000-2015.nc", netCDF::NcFile::read);
+	in_file.readMeta();
+
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+	v.setCoordBounds(v.lon_idx, 70, 80);
+	v.setCoordBounds(v.lat_idx, 15, 25);
+
+	flare::exportBinary(v, "tests/gpp.flarebc", 0, 50);
+
+	flare::MappedGeoCube<float> m("tests/gpp.flarebc");
+	if (m.nt() != 50 || m.sliceCounts() != v.sliceCounts() || m.name != v.name || m.dimnames != v.dimnames){
+		std::cout << "FAILED: metadata mismatch\n";
+		return 1;
+	}
+
+	std::vector<float> ref(v.sliceSize());
+	for (size_t t=0; t<m.nt(); ++t){
+		v.readSliceInto(t, ref.data());
+		const float* p = m.slice(t);
+		for (size_t i=0; i<ref.size(); ++i){
+			if (p[i] != ref[i] && !(std::isnan(p[i]) && std::isnan(ref[i]))){
+				std::cout << "FAILED: value mismatch in slice " << t << "\n";
+				return 1;
+			}
+		}
+		if (m.t_index_to_julian(t) != v.t_index_to_julian(t)){
+			std::cout << "FAILED: time mismatch in slice " << t << "\n";
+			return 1;
+		}
+		// (an exact hit on a time coordinate maps to the interval before it, so probe inside the interval)
+		double j = m.t_index_to_julian(t);
+		if (m.julian_to_index(j + 0.5*v.getTstep(), false, false) != t){
+			std::cout << "FAILED: julian_to_index mismatch in slice " << t << "\n";
+			return 1;
+		}
+		if (m.julian_to_index(j, false, false) != v.julian_to_index(j, false, false) || m.julian_to_index(j, false, true) != v.julian_to_index(j, false, true)){
+			std::cout << "FAILED: julian_to_index differs from GeoCube in slice " << t << "\n";
+			return 1;
+		}
+	}
+
+	// corrupt or foreign files are rejected (before anything out of the file is read)
+	std::ifstream fin("tests/gpp.flarebc", std::ios::binary);
+	std::string image((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+	flare::BinaryCacheHeader h;
+	std::memcpy(&h, image.data(), sizeof(h));
+	struct Query { std::string what; std::function<void(flare::BinaryCacheHeader&, std::string&)> corrupt; };
+	std::vector<Query> queries = {
+		{"truncated data",        [](flare::BinaryCacheHeader&, std::string& f){ f.resize(f.size() - 1); }},
+		{"too small",             [](flare::BinaryCacheHeader&, std::string& f){ f.resize(16); }},
+		{"bad magic",             [](flare::BinaryCacheHeader& h, std::string&){ h.magic[0] = 'X'; }},
+		{"too many dims",         [](flare::BinaryCacheHeader& h, std::string&){ h.ndims = 9; }},
+		{"dim index",             [](flare::BinaryCacheHeader& h, std::string&){ h.t_idx = int32_t(h.ndims); }},
+		{"huge dim",              [](flare::BinaryCacheHeader& h, std::string&){ h.dims[h.lat_idx] = uint64_t(1) << 62; }},
+		{"names out of range",    [](flare::BinaryCacheHeader& h, std::string& f){ h.names_bytes = f.size(); }},
+		{"unterminated names",    [](flare::BinaryCacheHeader& h, std::string&){ h.names_bytes = 2; }},
+		{"coords out of range",   [](flare::BinaryCacheHeader& h, std::string& f){ h.coords_offset = f.size() - 8; }},
+		{"data size mismatch",    [](flare::BinaryCacheHeader& h, std::string&){ h.data_bytes -= sizeof(float); }},
+	};
+	for (auto& q : queries){
+		flare::BinaryCacheHeader hc = h;
+		std::string f = image;
+		q.corrupt(hc, f);
+		if (f.size() >= sizeof(hc)) std::memcpy(&f[0], &hc, sizeof(hc));
+		std::ofstream("tests/bad.flarebc", std::ios::binary | std::ios::trunc).write(f.data(), f.size());
+		try{
+			flare::MappedGeoCube<float> bad("tests/bad.flarebc");
+			std::cout << "FAILED: binary cache with " << q.what << " accepted\n";
+			return 1;
+		}
+		catch(std::runtime_error&){}
+	}
+	std::remove("tests/bad.flarebc");
+
+	// slices unpacked on read are exported in physical units: the header must not unpack them again
+	v.unpack_on_read = true;
+	flare::exportBinary(v, "tests/gpp.flarebc", 0, 2);
+	m.open("tests/gpp.flarebc");
+	v.readSliceInto(1, ref.data());
+	if (m.scale_factor != 1 || m.add_offset != 0 || !std::isnan(m.missing_value) || std::memcmp(m.slice(1), ref.data(), ref.size()*sizeof(float)) != 0){
+		std::cout << "FAILED: header of an unpacked export (scale " << m.scale_factor << ", offset " << m.add_offset << ", missing " << m.missing_value << ")\n";
+		return 1;
+	}
+	m.close();
+
+	std::remove("tests/gpp.flarebc");
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <cmath>
+#include "../include/time_math.h"
+
+using flare::Calendar;
+
+// Check calendar arithmetic: round trips, month lengths, exact "months since" and the
+// mapping of dates between calendars
+int main(){
+
+	// parsing of CF calendar names
+	if (flare::calendar_from_string("Standard") != Calendar::gregorian ||
+	    flare::calendar_from_string("365_day") != Calendar::noleap ||
+	    flare::calendar_from_string("all_leap") != Calendar::all_leap ||
+	    flare::calendar_from_string("360_day") != Calendar::day_360){
+		std::cout << "FAILED: calendar_from_string\n";
+		return 1;
+	}
+	bool thrown = false;
+	try { flare::calendar_from_string("julian"); } catch (std::runtime_error&){ thrown = true; }
+	if (!thrown){ std::cout << "FAILED: unsupported calendar was accepted\n"; return 1; }
+
+	// every day of 1800-2200 in each calendar: consecutive day counts and round trips
+	for (Calendar c : {Calendar::gregorian, Calendar::noleap, Calendar::all_leap, Calendar::day_360}){
+		double prev = flare::calendar_days(c, 1800, 1, 1) - 1;
+		int ndays = 0;
+		for (int y=1800; y<2200; ++y){
+			for (int m=1; m<=12; ++m){
+				int dim = flare::with_calendar(c, [&](auto cal){ return cal.days_in_month(y, m); });
+				for (int d=1; d<=dim; ++d){
+					double days = flare::calendar_days(c, y, m, d, 6, 0, 0);
+					int y1, m1, d1, h1, mi1;
+					double s1;
+					flare::calendar_days_to_ymdhms(c, days, y1, m1, d1, h1, mi1, s1);
+					if (days - 0.25 != prev + 1 || y1 != y || m1 != m || d1 != d || h1 != 6){
+						std::cout << "FAILED: " << flare::calendar_name(c) << " " << y << "-" << m << "-" << d << " --> " << days
+						          << " --> " << y1 << "-" << m1 << "-" << d1 << " " << h1 << "h\n";
+						return 1;
+					}
+					prev = days - 0.25;
+					++ndays;
+				}
+			}
+		}
+		double expected = (c == Calendar::gregorian)? 146097 : 400*flare::calendar_days_per_year(c);
+		if (ndays != expected){
+			std::cout << "FAILED: " << flare::calendar_name(c) << " has " << ndays << " days in 400 years\n";
+			return 1;
+		}
+	}
+
+	// gregorian calendar days agree with julian days
+	double j = flare::datestring_to_julian("2001-12-18 12:10:45");
+	if (std::fabs(flare::julian_to_calendar_days(Calendar::gregorian, j) - flare::calendar_days(Calendar::gregorian, 2001, 12, 18, 12, 10, 45)) > 1e-9){
+		std::cout << "FAILED: gregorian calendar days\n";
+		return 1;
+	}
+
+	// mapping julian days to other calendars: same date, clamped to the month length
+	struct { Calendar c; std::string date; int y, m, d; } maps[] = {
+		{Calendar::noleap,   "2004-02-29 12:00:00", 2004, 2, 28},
+		{Calendar::noleap,   "2004-03-01 00:00:00", 2004, 3, 1},
+		{Calendar::all_leap, "2001-02-28 00:00:00", 2001, 2, 28},
+		{Calendar::day_360,  "2001-01-31 00:00:00", 2001, 1, 30},
+		{Calendar::day_360,  "2001-02-28 00:00:00", 2001, 2, 28},
+	};
+	for (auto& t : maps){
+		double cd = flare::julian_to_calendar_days(t.c, flare::datestring_to_julian(t.date));
+		if (std::floor(cd) != flare::calendar_days(t.c, t.y, t.m, t.d)){
+			std::cout << "FAILED: " << t.date << " in " << flare::calendar_name(t.c) << "\n";
+			return 1;
+		}
+	}
+	double jfeb30 = flare::calendar_days_to_julian(Calendar::day_360, flare::calendar_days(Calendar::day_360, 2001, 2, 30));
+	if (jfeb30 != flare::datestring_to_julian("2001-02-28")){
+		std::cout << "FAILED: 360_day Feb 30 --> " << flare::julian_to_datestring(jfeb30) << "\n";
+		return 1;
+	}
+
+	// batch version
+	std::vector<double> js, cds(400);
+	for (int k=0; k<400; ++k) js.push_back(2451544.5 + k*1.3);
+	flare::julian_to_calendar_days(Calendar::noleap, js.data(), js.size(), cds.data());
+	for (int k=0; k<400; ++k){
+		if (cds[k] != flare::julian_to_calendar_days(Calendar::noleap, js[k])){
+			std::cout << "FAILED: batch julian_to_calendar_days\n";
+			return 1;
+		}
+	}
+
+	// exact months since 1850-01-01: month starts and mid-months
+	for (Calendar c : {Calendar::gregorian, Calendar::noleap, Calendar::day_360}){
+		double base = flare::calendar_days(c, 1850, 1, 1);
+		for (int k=0; k<1200; ++k){
+			int y = 1850 + k/12, m = k%12 + 1;
+			double start = flare::calendar_add_months(c, 1850, 1, 1, k) - base;
+			double mid   = flare::calendar_add_months(c, 1850, 1, 1, k + 0.5) - base;
+			int dim = flare::with_calendar(c, [&](auto cal){ return cal.days_in_month(y, m); });
+			if (start != flare::calendar_days(c, y, m, 1) - base || mid != start + dim/2.0){
+				std::cout << "FAILED: " << flare::calendar_name(c) << ": " << k << " months since 1850-01-01 = " << start << " / " << mid << " days\n";
+				return 1;
+			}
+		}
+	}
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <cstdio>
+#include <cstring>
+#include "flare.h"
+
+// (time, lat, lon) = (5, 10, 12) file with chunks of (2, 4, 5), so that the last chunk along each dim is partial:
+//   x  float, deflate + shuffle, _FillValue -999: x = t*1000 + i*20 + j where written
+//   p  short, deflate, packed (scale 0.5, offset 10), _FillValue -32767
+//   c  float (lat, lon), contiguous (not chunked): c = x at t = 0
+// Only t = 0..2 (without the chunk at the far lat/lon corner) and the cell (4, 0, 0) are written, so that some
+// chunks are never allocated, and one chunk (t = 2..3) is allocated but only partly written.
+static bool written(size_t t, size_t i, size_t j){
+	return (t <= 2 && !(i >= 8 && j >= 10)) || (t == 4 && i == 0 && j == 0);
+}
+static float x_value(size_t t, size_t i, size_t j){ return float(t*1000 + i*20 + j); }
+static int16_t p_value(size_t t, size_t i, size_t j){ return int16_t(int(t*100 + i*10 + j) % 300 - 150); }
+
+static void write_file(const std::string& path){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time"), latdim = f.addDim("lat", 10), londim = f.addDim("lon", 12);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	std::vector<netCDF::NcDim> dims = {tdim, latdim, londim};
+	std::vector<size_t> chunks = {2, 4, 5};
+
+	netCDF::NcVar x = f.addVar("x", netCDF::ncFloat, dims);
+	x.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+	x.setCompression(true, true, 4);
+	x.putAtt("_FillValue", netCDF::ncFloat, -999.f);
+	x.putAtt("units", "1");
+
+	netCDF::NcVar p = f.addVar("p", netCDF::ncShort, dims);
+	p.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+	p.setCompression(false, true, 4);
+	p.putAtt("_FillValue", netCDF::ncShort, int16_t(-32767));
+	p.putAtt("scale_factor", netCDF::ncFloat, 0.5f);
+	p.putAtt("add_offset", netCDF::ncFloat, 10.f);
+	p.putAtt("units", "1");
+
+	std::vector<size_t> no_chunks;
+	netCDF::NcVar c = f.addVar("c", netCDF::ncFloat, std::vector<netCDF::NcDim>{latdim, londim});
+	c.setChunking(netCDF::NcVar::nc_CONTIGUOUS, no_chunks);
+	c.putAtt("units", "1");
+
+	std::vector<double> ts = {0, 1, 2, 3, 4}, lats, lons;
+	for (int i=0; i<10; ++i) lats.push_back(-45 + 10*i);
+	for (int j=0; j<12; ++j) lons.push_back(30*j);   // 0 ... 330: periodic
+	tvar.putVar(std::vector<size_t>{0}, std::vector<size_t>{5}, ts.data());
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+
+	// write row by row, leaving out the cells that are not written
+	for (size_t t=0; t<5; ++t){
+		for (size_t i=0; i<10; ++i){
+			size_t n = 0;
+			while (n < 12 && written(t, i, n)) ++n;
+			if (n == 0) continue;
+			std::vector<float> xr(n);
+			std::vector<int16_t> pr(n);
+			for (size_t j=0; j<n; ++j){ xr[j] = x_value(t, i, j); pr[j] = p_value(t, i, j); }
+			std::vector<size_t> s = {t, i, 0}, k = {1, 1, n};
+			x.putVar(s, k, xr.data());
+			p.putVar(s, k, pr.data());
+			if (t == 0) c.putVar(std::vector<size_t>{i, 0}, std::vector<size_t>{1, n}, xr.data());
+		}
+	}
+}
+
+// Reads with parallel chunk decompression (setDecompressionPool) must give the same data as reads through
+// getVar, and both the values in the file: across partial edge chunks, in unallocated and partly written
+// chunks (fill values), for packed data, wrapped lon ranges (written in place through imap), chunk-aligned
+// sub-reads, and the fallbacks to getVar (strided reads, type mismatch, contiguous variables).
+// If the build has no HDF5 support, both paths are getVar.
+int main(){
+	std::string path = "tests/chunk_reader.nc";
+	write_file(path);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+
+	flare::ThreadPool pool(4);
+
+	struct Query { std::string var; size_t t, nt, lat0, nlat; double lon0, lon1; ptrdiff_t lon_stride; bool unpack; size_t max_read_bytes; };
+	std::vector<Query> queries = {
+		{"x", 0, 1, 0, 10,    0, 330, 1, false, 0},     // full slice
+		{"x", 1, 3, 3,  6,   40, 200, 1, false, 0},     // window across chunk boundaries, into the partly written chunk
+		{"x", 0, 1, 8,  2,  310, 330, 1, false, 0},     // unallocated chunk only
+		{"x", 3, 2, 0, 10,    0, 330, 1, false, 0},     // mostly unallocated, one written cell
+		{"x", 0, 3, 2,  7,  270,  60, 1, false, 0},     // wrapped lon range, across the last (partial) lon chunk
+		{"x", 0, 3, 0, 10,    0, 330, 2, false, 0},     // strided: falls back to getVar
+		{"x", 0, 5, 0, 10,    0, 330, 1, false, 400},   // chunk-aligned sub-reads
+		{"p", 1, 4, 2,  8,  100, 330, 1, true,  0},     // packed, unpacked on read (fill -> NaN)
+		{"p", 1, 4, 2,  8,  100, 330, 1, false, 0},     // packed, read as float: type mismatch, falls back to getVar
+	};
+
+	int nfail = 0;
+	bool active = false;
+	for (auto& q : queries){
+		flare::GeoCube<float> ref, par;
+		ref.readMeta(in_file, q.var);
+		par.readMeta(in_file, q.var);
+		active = par.setDecompressionPool(&pool) || active;
+
+		size_t lon_start = 0, lon_count = 0;
+		for (auto* c : {&ref, &par}){
+			c->unpack_on_read = q.unpack;
+			c->max_read_bytes = q.max_read_bytes;
+			c->setIndexRange(c->lat_idx, q.lat0, q.nlat);
+			c->setLonBounds(q.lon0, q.lon1);
+			lon_start = c->getStarts()[c->lon_idx];
+			lon_count = c->getCounts()[c->lon_idx];
+			if (q.lon_stride != 1){
+				lon_count = (lon_count + q.lon_stride - 1)/q.lon_stride;
+				c->setIndices(c->lon_idx, lon_start, lon_count, q.lon_stride);
+			}
+			c->readBlock(q.t, q.nt);
+		}
+
+		// expected values, from what was written
+		std::vector<float> expected;
+		for (size_t t=q.t; t<q.t+q.nt; ++t){
+			for (size_t i=q.lat0; i<q.lat0+q.nlat; ++i){
+				for (size_t k=0; k<lon_count; ++k){
+					size_t j = (lon_start + k*q.lon_stride) % 12;
+					bool w = written(t, i, j);
+					if (q.var == "x") expected.push_back(w? x_value(t, i, j) : -999.f);
+					else if (q.unpack) expected.push_back(w? p_value(t, i, j)*0.5f + 10 : std::nanf(""));
+					else expected.push_back(w? p_value(t, i, j) : -32767.f);
+				}
+			}
+		}
+
+		for (auto* c : {&ref, &par}){
+			bool same = c->vec.size() == expected.size();
+			for (size_t i=0; same && i<expected.size(); ++i){
+				same = (c->vec[i] == expected[i]) || (std::isnan(c->vec[i]) && std::isnan(expected[i]));
+			}
+			if (!same){
+				std::cout << "FAILED: " << ((c == &ref)? "getVar" : "parallel") << " read of " << q.var << " for lat [" << q.lat0 << " + " << q.nlat
+				          << "], lon [" << q.lon0 << ", " << q.lon1 << "] / " << q.lon_stride << ", t = " << q.t << " + " << q.nt << "\n";
+				++nfail;
+			}
+		}
+	}
+	std::cout << "parallel decompression " << (active? "active" : "not available, testing getVar only") << "\n";
+
+	// contiguous variables are never read through the chunk reader
+	flare::GeoCube<float> c;
+	c.readMeta(in_file, "c");
+	if (c.setDecompressionPool(&pool)){
+		std::cout << "FAILED: parallel decompression set up for a contiguous variable\n";
+		++nfail;
+	}
+	c.readBlock(0, 1);
+	if (c.vec.size() != 120 || c.vec[0] != x_value(0, 0, 0) || c.vec[7*12 + 11] != x_value(0, 7, 11)){
+		std::cout << "FAILED: read of contiguous variable\n";
+		++nfail;
+	}
+
+	in_file.close();
+	std::remove(path.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
@@ -0,0 +1,198 @@
+#include <cstdio>
+#include <thread>
+#include "flare.h"
+
+// (time, lat, lon) = (nt, 8, 12) file on a periodic 0 ... 330 lon axis, starting at day t0, with
+//   x  float, chunks (1, 4, 6): x = t*1000 + i*20 + j (t on the joined time axis)
+//   p  short, packed (scale 0.5, offset 10)
+static float x_value(size_t t, size_t i, size_t j){ return float(t*1000 + i*20 + j); }
+static int16_t p_value(size_t t, size_t i, size_t j){ return int16_t(int(t*100 + i*10 + j) % 300 - 150); }
+
+static void write_file(const std::string& path, size_t t0, size_t nt){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time"), latdim = f.addDim("lat", 8), londim = f.addDim("lon", 12);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	std::vector<netCDF::NcDim> dims = {tdim, latdim, londim};
+	std::vector<size_t> chunks = {1, 4, 6};
+	netCDF::NcVar x = f.addVar("x", netCDF::ncFloat, dims);
+	x.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+	x.putAtt("units", "1");
+	netCDF::NcVar p = f.addVar("p", netCDF::ncShort, dims);
+	p.putAtt("scale_factor", netCDF::ncFloat, 0.5f);
+	p.putAtt("add_offset", netCDF::ncFloat, 10.f);
+	p.putAtt("units", "1");
+
+	std::vector<double> lats, lons;
+	for (int i=0; i<8; ++i) lats.push_back(-35 + 10*i);
+	for (int j=0; j<12; ++j) lons.push_back(30*j);
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	for (size_t t=0; t<nt; ++t){
+		double tv = t0 + t;
+		std::vector<float> xs;
+		std::vector<int16_t> ps;
+		for (size_t i=0; i<8; ++i) for (size_t j=0; j<12; ++j){ xs.push_back(x_value(t0+t, i, j)); ps.push_back(p_value(t0+t, i, j)); }
+		tvar.putVar(std::vector<size_t>{t}, std::vector<size_t>{1}, &tv);
+		x.putVar(std::vector<size_t>{t, 0, 0}, std::vector<size_t>{1, 8, 12}, xs.data());
+		p.putVar(std::vector<size_t>{t, 0, 0}, std::vector<size_t>{1, 8, 12}, ps.data());
+	}
+}
+
+// Many threads read different hyperslabs from the same cubes through the const read API at once: plain, split into
+// chunk-aligned sub-reads, packed (unpacked through per-thread buffers), wrapped around the lon axis (read in pieces
+// through imap), strided, and across the files of an MFGeoCube. Every read must give the values in the file, the
+// cubes (hyperslab, data) must not change, and the slice cache attached to a cube must not be used. Metadata is
+// read again on another thread at the same time.
+int main(){
+	std::vector<std::string> paths = {"tests/concurrent_read.nc", "tests/concurrent_read_0.nc", "tests/concurrent_read_1.nc"};
+	write_file(paths[0], 0, 6);
+	write_file(paths[1], 0, 3);
+	write_file(paths[2], 3, 3);
+
+	flare::NcFilePP in_file;
+	in_file.open(paths[0], netCDF::NcFile::read);
+	in_file.readMeta();
+
+	enum Reader { plain, split, packed, multifile };
+	std::vector<std::string> reader_names = {"plain", "split", "packed", "multifile"};
+	flare::GeoCube<float> x, xs, p;
+	x.readMeta(in_file, "x");
+	xs.readMeta(in_file, "x");
+	xs.max_read_bytes = 200;   // (sub-reads of 50 values)
+	p.readMeta(in_file, "p");
+	p.unpack_on_read = true;
+	flare::MFGeoCube<float> mf;
+	mf.open(std::vector<std::string>{paths[1], paths[2]}, "x");
+	std::vector<const flare::GeoCube<float>*> readers = {&x, &xs, &p, &mf};
+
+	flare::SliceCache<float> cache(1024*1024);
+	x.setCache(&cache);
+	x.setCoordBounds(x.lat_idx, -10, 10);
+	x.readBlock(2, 1);
+	std::vector<float> x_before = x.vec;
+	auto cache_before = cache.stats();
+	std::vector<flare::Hyperslab> before;
+	for (auto r : readers) before.push_back(r->hyperslab());
+
+	struct Query { size_t t, nt, lat0, nlat; double lon0, lon1; ptrdiff_t lon_stride; };
+	std::vector<Query> queries = {
+		{0, 1, 0, 8,    0, 330, 1},   // full slice
+		{1, 4, 2, 5,   40, 200, 1},   // window, across the files of the MFGeoCube
+		{2, 1, 3, 1,   95,  95, 1},   // a single point (between two columns)
+		{0, 6, 0, 8,  270,  60, 1},   // wrapped around the lon axis, all time steps
+		{3, 2, 1, 6,  -70,  70, 1},   // wrapped, in the other lon convention
+		{1, 3, 0, 8,    0, 330, 3},   // strided along lon
+		{5, 1, 0, 8,    0, 330, 1},   // last time step
+	};
+
+	// the hyperslab of each query (the same for all readers, which share the grid and joined time axis)
+	std::vector<flare::Hyperslab> slabs;
+	std::vector<std::vector<size_t>> cols;   // lon indices of each query
+	for (auto& q : queries){
+		flare::Hyperslab h = x.withIndices(x.hyperslab(), x.t_idx, q.t, q.nt);
+		h = x.withIndices(h, x.lat_idx, q.lat0, q.nlat);
+		h = x.withLonBounds(h, q.lon0, q.lon1);
+		if (q.lon_stride != 1) h = x.withIndices(h, x.lon_idx, h.starts[x.lon_idx], (h.counts[x.lon_idx] + q.lon_stride - 1)/q.lon_stride, q.lon_stride);
+		std::vector<size_t> c;
+		for (size_t k=0; k<h.counts[x.lon_idx]; ++k) c.push_back((h.starts[x.lon_idx] + k*q.lon_stride) % 12);
+		slabs.push_back(h);
+		cols.push_back(c);
+	}
+
+	auto matches = [&](int reader, size_t qi, const std::vector<float>& buf){
+		auto& q = queries[qi];
+		size_t k = 0;
+		if (buf.size() != slabs[qi].size()) return false;
+		for (size_t t=q.t; t<q.t+q.nt; ++t){
+			for (size_t i=q.lat0; i<q.lat0+q.nlat; ++i){
+				for (size_t j : cols[qi]){
+					float e = (reader == packed)? p_value(t, i, j)*0.5f + 10 : x_value(t, i, j);
+					if (buf[k++] != e) return false;
+				}
+			}
+		}
+		return true;
+	};
+
+	// each thread reads every (reader, query) pair, starting at a different one
+	int nfail_meta = 0;
+	size_t nthreads = 8, npairs = readers.size()*queries.size();
+	std::vector<std::vector<int>> failures(nthreads, std::vector<int>(npairs, 0));
+	std::vector<std::thread> threads;
+	for (size_t th=0; th<nthreads; ++th){
+		threads.emplace_back([&, th](){
+			std::vector<float> buf;
+			for (int rep=0; rep<20; ++rep){
+				for (size_t m=0; m<npairs; ++m){
+					size_t pair = (m + th*5) % npairs, r = pair / queries.size(), qi = pair % queries.size();
+					try{
+						readers[r]->read(slabs[qi], buf);
+						if (!matches(r, qi, buf)) ++failures[th][pair];
+					}
+					catch(std::exception&){ ++failures[th][pair]; }
+				}
+			}
+		});
+	}
+	// meanwhile, another thread reads the metadata of the file and its variables again (netCDF calls, too)
+	int meta_failures = 0;
+	threads.emplace_back([&](){
+		for (int rep=0; rep<50; ++rep){
+			try{
+				in_file.readMeta();
+				flare::GeoCube<float> g;
+				g.readMeta(in_file, (rep % 2)? "p" : "x");
+				if (g.getCounts() != std::vector<size_t>{1, 8, 12} || g.coords[g.lon_idx].size() != 12 || g.getTstep() != 1) ++meta_failures;
+			}
+			catch(std::exception&){ ++meta_failures; }
+		}
+	});
+	for (auto& t : threads) t.join();
+	if (meta_failures > 0){
+		std::cout << "FAILED: " << meta_failures << " metadata reads during concurrent reads\n";
+		++nfail_meta;
+	}
+
+	int nfail = nfail_meta;
+	for (size_t pair=0; pair<npairs; ++pair){
+		int n = 0;
+		for (auto& f : failures) n += f[pair];
+		if (n > 0){
+			auto& q = queries[pair % queries.size()];
+			std::cout << "FAILED: " << n << " " << reader_names[pair / queries.size()] << " reads of lat [" << q.lat0 << " + " << q.nlat << "], lon [" << q.lon0
+			          << ", " << q.lon1 << "] / " << q.lon_stride << ", t = " << q.t << " + " << q.nt << " differ from the file\n";
+			++nfail;
+		}
+	}
+
+	for (size_t r=0; r<readers.size(); ++r){
+		if (!(readers[r]->hyperslab() == before[r])){
+			std::cout << "FAILED: the hyperslab of the " << reader_names[r] << " reader was modified\n";
+			++nfail;
+		}
+	}
+	auto cache_after = cache.stats();
+	if (x.vec != x_before || cache_after.hits != cache_before.hits || cache_after.misses != cache_before.misses){
+		std::cout << "FAILED: concurrent reads changed the cube's data or used its slice cache\n";
+		++nfail;
+	}
+
+	// hyperslabs of the wrong rank are rejected
+	try{
+		std::vector<float> buf;
+		x.read(flare::Hyperslab{{0, 0}, {1, 1}, {1, 1}}, buf);
+		std::cout << "FAILED: hyperslab of the wrong rank accepted\n";
+		++nfail;
+	}
+	catch(std::runtime_error&){}
+
+	in_file.close();
+	for (auto& path : paths) std::remove(path.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cmath>
+#include "flare.h"
+
+// Check zero-copy views of a (lat, time, lon) block: time slices, windows, coordinate ranges,
+// packing of non-contiguous views, and regridding from a view
+int main(){
+
+	size_t nlat = 20, nt = 6, nlon = 36;
+	std::vector<double> lats(nlat), times(nt), lons(nlon);
+	for (size_t i=0; i<nlat; ++i) lats[i] = 85.5 - 9*i;   // descending
+	for (size_t k=0; k<nt; ++k) times[k] = 10 + k;
+	for (size_t j=0; j<nlon; ++j) lons[j] = 5 + 10*j;
+
+	std::vector<float> block(nlat*nt*nlon);
+	auto value = [](size_t i, size_t k, size_t j){ return float(i*10000 + k*100 + j); };
+	for (size_t i=0; i<nlat; ++i)
+		for (size_t k=0; k<nt; ++k)
+			for (size_t j=0; j<nlon; ++j) block[(i*nt + k)*nlon + j] = value(i, k, j);
+
+	flare::CubeView<float> v(block.data(), {nlat, nt, nlon});
+	v.coords = {lats.data(), times.data(), lons.data()};
+	v.lat_idx = 0; v.t_idx = 1; v.lon_idx = 2;
+	if (!v.contiguous() || v.size() != block.size()){
+		std::cout << "FAILED: full view\n";
+		return 1;
+	}
+
+	// time slice: not contiguous (time is not the outermost dim), no copy of the data
+	flare::CubeView<const float> s = v.timeSlice(3);
+	if (s.contiguous() || s.size() != nlat*nlon || s.data != block.data() + 3*nlon || s.coords[1][0] != 13){
+		std::cout << "FAILED: timeSlice\n";
+		return 1;
+	}
+	std::vector<float> packed = s.toVector();
+	for (size_t i=0; i<nlat; ++i)
+		for (size_t j=0; j<nlon; ++j)
+			if (packed[i*nlon + j] != value(i, 3, j)){
+				std::cout << "FAILED: packed time slice at " << i << "," << j << "\n";
+				return 1;
+			}
+
+	// window and coordinate ranges (same bracketing as setCoordBounds)
+	auto w = s.coordRange(0, -10, 30).coordRange(2, 100, 200);
+	std::vector<double> wl = w.coordValues(0), wn = w.coordValues(2);
+	if (wl.front() != 31.5 || wl.back() != -13.5 || wn.front() != 95 || wn.back() != 205){
+		std::cout << "FAILED: coordRange gives lats " << wl << "and lons " << wn;
+		return 1;
+	}
+	size_t i0 = 6, j0 = 9;
+	for (size_t i=0; i<w.shape[0]; ++i)
+		for (size_t j=0; j<w.shape[2]; ++j)
+			if (w.at({i, 0, j}) != value(i0+i, 3, j0+j)){
+				std::cout << "FAILED: window value at " << i << "," << j << "\n";
+				return 1;
+			}
+	auto w2 = v.window(6, w.shape[0], 9, w.shape[2]).timeSlice(3);
+	if (w2.toVector() != w.toVector()){
+		std::cout << "FAILED: window() and coordRange() differ\n";
+		return 1;
+	}
+
+	// writes through a view
+	v.timeSlice(0).range(0, 0, 1).at({0, 0, 5}) = -1;
+	if (block[5] != -1){
+		std::cout << "FAILED: write through view\n";
+		return 1;
+	}
+	block[5] = value(0, 0, 5);
+
+	// regridding a time slice in place vs from a packed copy
+	std::vector<double> dst_lats = {60, 30, 0, -30, -60}, dst_lons = {20, 90, 180, 270};
+	flare::Regridder r(lats, lons, dst_lats, dst_lons, flare::RegridMethod::bilinear);
+	Tensor<float> a = r.apply(s);
+	std::vector<float> b(dst_lats.size()*dst_lons.size());
+	r.apply(packed.data(), b.data(), float(-999));
+	if (a.vec != b){
+		std::cout << "FAILED: regridding a view\n";
+		return 1;
+	}
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
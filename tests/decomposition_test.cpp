@@ -0,0 +1,143 @@
+#include <iostream>
+#include <cmath>
+#include <sys/wait.h>
+#include "../include/decomposition.h"
+
+// Check the lat/lon decomposition (coverage, balance, masked tiles), and collective reads through
+// shared memory with one leader and several local worker processes
+int main(){
+
+	// ~~ decomposition of a 180 x 360 window with a mask (two "continents")
+	size_t nlat = 180, nlon = 360;
+	std::vector<char> mask(nlat*nlon, 0);
+	for (size_t i=0; i<nlat; ++i)
+		for (size_t j=0; j<nlon; ++j)
+			mask[i*nlon+j] = (i > 20 && i < 80 && j > 30 && j < 150) || (i > 100 && i < 170 && j > 200 && j < 250);
+
+	int nranks = 16, ranks_per_node = 4;
+	flare::Decomposition dec = flare::decompose(10, nlat, 5, nlon, nranks, 4, mask, ranks_per_node);
+	std::vector<int> covered(nlat*nlon, 0);
+	for (auto& t : dec.tiles){
+		if (t.weight == 0 || t.rank < 0 || t.rank >= nranks || t.lat_start < 10 || t.lon_start < 5 || t.lat_start+t.lat_count > 10+nlat || t.lon_start+t.lon_count > 5+nlon){
+			std::cout << "FAILED: invalid tile\n";
+			return 1;
+		}
+		for (size_t i=t.lat_start-10; i<t.lat_start-10+t.lat_count; ++i)
+			for (size_t j=t.lon_start-5; j<t.lon_start-5+t.lon_count; ++j) ++covered[i*nlon+j];
+	}
+	for (size_t k=0; k<mask.size(); ++k){
+		if (covered[k] > 1 || (mask[k] && covered[k] != 1)){
+			std::cout << "FAILED: point " << k << " is covered " << covered[k] << " times\n";
+			return 1;
+		}
+	}
+	std::cout << "tiles = " << dec.tiles.size() << ", imbalance = " << dec.imbalance() << "\n";
+	if (dec.imbalance() > 1.1){
+		dec.print();
+		std::cout << "FAILED: decomposition is not balanced\n";
+		return 1;
+	}
+
+	// the slabs read by each node (bounding boxes of their tiles) must not overlap, and together must be
+	// much smaller than the window (the valid points cover 16% of it)
+	std::vector<flare::Tile> slabs;
+	size_t slab_area = 0;
+	for (int r=0; r<nranks; r+=ranks_per_node){
+		slabs.push_back(dec.bounds(r, ranks_per_node));
+		slab_area += slabs.back().lat_count * slabs.back().lon_count;
+	}
+	for (size_t a=0; a<slabs.size(); ++a){
+		for (size_t b=a+1; b<slabs.size(); ++b){
+			auto& x = slabs[a];
+			auto& y = slabs[b];
+			if (x.lat_start < y.lat_start+y.lat_count && y.lat_start < x.lat_start+x.lat_count &&
+			    x.lon_start < y.lon_start+y.lon_count && y.lon_start < x.lon_start+x.lon_count){
+				std::cout << "FAILED: slabs of nodes " << a << " and " << b << " overlap\n";
+				return 1;
+			}
+		}
+	}
+	std::cout << "node slabs cover " << double(slab_area)/(nlat*nlon) << " of the window\n";
+	if (slab_area > nlat*nlon/2){
+		dec.print();
+		std::cout << "FAILED: node slabs are too large\n";
+		return 1;
+	}
+
+	// ~~ collective read: 4 processes on one node, slab = [time, lat, lon] over the node's tiles
+	int nlocal = 4;
+	dec = flare::decompose(0, nlat, 0, nlon, nlocal, 3, mask);
+	flare::Tile b = dec.bounds(0, nlocal);
+	auto value = [](size_t t, size_t i, size_t j){ return float(t*1000000 + i*1000 + j); };
+
+	std::string shm_name = "flare_decomposition_test_" + std::to_string(getpid()); // (named before forking, so that all ranks agree)
+
+	// leave a segment behind as a crashed run would (initialized, but its leader is gone): workers must not use it
+	{
+		pid_t pid = fork();
+		if (pid == 0){
+			flare::SlabLayout layout;
+			layout.counts = {1, b.lat_count, b.lon_count};
+			layout.lat_idx = 1; layout.lon_idx = 2; layout.unlim_idx = 0;
+			auto stale = new flare::CollectiveReader<float>(shm_name, 0, nlocal, 0, dec, layout, [](size_t, size_t, float*){}, 2);
+			(void)stale;
+			_exit(0); // (no destructor: the segment is not unlinked)
+		}
+		int status;
+		waitpid(pid, &status, 0);
+	}
+	auto run = [&](int rank) -> int {
+		flare::SlabLayout layout;
+		flare::CollectiveReader<float>::ReadFn read;
+		if (rank == 0){
+			layout.counts = {1, b.lat_count, b.lon_count};
+			layout.lat_idx = 1; layout.lon_idx = 2; layout.unlim_idx = 0;
+			read = [&](size_t t0, size_t nt, float* buf){
+				for (size_t k=0; k<nt; ++k)
+					for (size_t i=0; i<b.lat_count; ++i)
+						for (size_t j=0; j<b.lon_count; ++j)
+							buf[(k*b.lat_count + i)*b.lon_count + j] = value(t0+k, b.lat_start+i, b.lon_start+j);
+			};
+		}
+		flare::CollectiveReader<float> reader(shm_name, rank, nlocal, rank, dec, layout, read, 2);
+		for (size_t t0 : {5, 7}){
+			reader.readBlock(t0, 2);
+			for (size_t n=0; n<reader.tiles.size(); ++n){
+				auto& t = reader.tiles[n];
+				auto& d = reader.data[n];
+				if (reader.tileCounts(n) != std::vector<size_t>{2, t.lat_count, t.lon_count}) return 1;
+				for (size_t k=0; k<2; ++k)
+					for (size_t i=0; i<t.lat_count; ++i)
+						for (size_t j=0; j<t.lon_count; ++j)
+							if (d[(k*t.lat_count + i)*t.lon_count + j] != value(t0+k, t.lat_start+i, t.lon_start+j)) return 1;
+			}
+		}
+		return 0;
+	};
+
+	std::vector<pid_t> children;
+	for (int r=1; r<nlocal; ++r){
+		pid_t pid = fork();
+		if (pid == 0){
+			int status = 1;
+			try{ status = run(r); }
+			catch (std::exception& e){ std::cout << "rank " << r << ": " << e.what() << "\n"; }
+			_exit(status);
+		}
+		children.push_back(pid);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(200)); // (workers find the stale segment before the leader replaces it)
+	int failed = run(0);
+	for (auto pid : children){
+		int status;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+	}
+	if (failed){
+		std::cout << "FAILED: collective read\n";
+		return 1;
+	}
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
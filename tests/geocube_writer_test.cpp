@@ -0,0 +1,96 @@
+#include <cstdio>
+#include "flare.h"
+
+// Write slices of a cube to a new file through the background writer, read the file back,
+// and check data, coordinates and times
+int main(){
+
+	flare::NcFilePP in_file;
+	in_file.open("tests/data/gpp.2000-2015.nc", netCDF::NcFile::read);
+	in_file.readMeta();
+
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+	v.setCoordBounds(v.lon_idx, 70, 80);
+	v.setCoordBounds(v.lat_idx, 15, 25);
+
+	const size_t nt = 40;
+	{
+		flare::WriterOptions opt;
+		opt.chunks = v.sliceCounts();
+		opt.chunks[v.t_idx] = 16; // last block is partial
+		opt.queue_slices = 4;
+		flare::GeoCubeWriter<float> writer("tests/writer_test.nc", v, opt);
+		for (size_t k=0; k<nt; ++k){
+			v.readBlock(k, 1);
+			writer.append(v, v.t_index_to_julian(k));
+		}
+
+		// views must match the output slice dim by dim, not just in size
+		std::vector<size_t> reshaped = v.sliceCounts();
+		reshaped[v.lat_idx] *= reshaped[v.lon_idx];
+		reshaped[v.lon_idx] = 1;
+		flare::CubeView<const float> tv(v.vec.data(), reshaped);
+		tv.lat_idx = v.lat_idx;
+		tv.lon_idx = v.lon_idx;
+		flare::CubeView<const float> fv(v.vec.data(), v.sliceCounts());
+		fv.lat_idx = v.lon_idx;
+		fv.lon_idx = v.lat_idx;
+		for (auto bad : {tv, fv}){
+			try{
+				writer.append(bad, v.t_index_to_julian(nt));
+				std::cout << "FAILED: view of the wrong shape or dim order accepted\n";
+				return 1;
+			}
+			catch(std::runtime_error&){}
+		}
+		writer.close();
+		if (writer.written() != nt){
+			std::cout << "FAILED: " << writer.written() << " slices written instead of " << nt << "\n";
+			return 1;
+		}
+	}
+
+	flare::NcFilePP out_file;
+	out_file.open("tests/writer_test.nc", netCDF::NcFile::read);
+	out_file.readMeta();
+	flare::GeoCube<float> w;
+	w.readMeta(out_file);
+
+	if (w.coords_trimmed[w.t_idx].size() != nt || w.coords[w.lat_idx] != v.coords_trimmed[v.lat_idx] || w.coords[w.lon_idx] != v.coords_trimmed[v.lon_idx]){
+		std::cout << "FAILED: coordinates differ\n";
+		return 1;
+	}
+
+	std::vector<float> a(v.sliceSize()), b(w.sliceSize());
+	for (size_t k=0; k<nt; ++k){
+		if (std::fabs(w.t_index_to_julian(k) - v.t_index_to_julian(k)) > 1e-6){
+			std::cout << "FAILED: time of slice " << k << " differs\n";
+			return 1;
+		}
+		v.readSliceInto(k, a.data());
+		w.readSliceInto(k, b.data());
+		for (size_t i=0; i<a.size(); ++i){
+			if (a[i] != b[i] && !(std::isnan(a[i]) && std::isnan(b[i]))){
+				std::cout << "FAILED: value mismatch in slice " << k << "\n";
+				return 1;
+			}
+		}
+	}
+
+	// views of a strided window have no coordinates along the strided dim
+	v.setIndices(v.lon_idx, v.getStarts()[v.lon_idx], v.getCounts()[v.lon_idx]/2, 2);
+	auto vc = flare::cube_view_coords(v);
+	if (vc[v.lon_idx] != nullptr || vc[v.lat_idx] == nullptr){
+		std::cout << "FAILED: coordinates of a strided view\n";
+		return 1;
+	}
+
+	out_file.close();
+	std::remove("tests/writer_test.nc");
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include <cstdio>
+#include "flare.h"
+
+// small (time, lat, lon) file with a variable x
+static void write_file(const std::string& path){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time", 2), latdim = f.addDim("lat", 3), londim = f.addDim("lon", 4);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	std::vector<double> ts = {0, 1}, lats = {-10, 0, 10}, lons = {0, 10, 20, 30};
+	std::vector<float> data(24, 1.f);
+	tvar.putVar(ts.data());
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	v.putVar(data.data());
+}
+
+// Check that instrumented scopes are counted only while enabled, and that stats can be exported.
+// Labels may be temporaries, and per-variable stats are kept apart for variables of the same name in different files.
+int main(){
+
+	std::vector<size_t> shape = {1, 10, 20};
+	std::string label = "var";
+	auto read = [&](){ FLARE_INSTRUMENT_SCOPE("getVar", label, 800, &shape); };
+
+	read(); // disabled by default
+	if (!flare::instrument::snapshot().empty()){
+		std::cout << "FAILED: calls recorded while disabled\n";
+		return 1;
+	}
+
+	flare::instrument::enable(true, true);
+	for (int i=0; i<5; ++i) read();
+	flare::instrument::enable(false);
+	read();
+
+	auto c = flare::instrument::snapshot()["getVar"]["var"];
+	if (c.calls != 5 || c.bytes != 4000 || c.shapes[shape] != 5){
+		std::cout << "FAILED: counters = " << c.calls << " calls, " << c.bytes << " bytes\n";
+		return 1;
+	}
+
+	flare::instrument::Registry::instance().writeChromeTrace("tests/instrument_trace.json");
+	flare::instrument::Registry::instance().writeJson("tests/instrument_stats.json");
+	std::ifstream fin("tests/instrument_trace.json");
+	std::string trace((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+	size_t nev = 0;
+	for (size_t p = trace.find("\"ph\":\"X\""); p != std::string::npos; p = trace.find("\"ph\":\"X\"", p+1)) ++nev;
+	std::remove("tests/instrument_trace.json");
+	std::remove("tests/instrument_stats.json");
+	if (nev != 5){
+		std::cout << "FAILED: " << nev << " trace events instead of 5\n";
+		return 1;
+	}
+
+	flare::instrument::reset();
+	if (!flare::instrument::snapshot().empty()){
+		std::cout << "FAILED: reset did not clear counters\n";
+		return 1;
+	}
+
+	// the label is a temporary that is destroyed before the scope ends
+	flare::instrument::enable(true);
+	{
+		FLARE_INSTRUMENT_SCOPE("getVar", std::string("tmp_") + label, 8);
+		std::string other(64, 'x'); // (reuses the memory of the temporary)
+	}
+	flare::instrument::enable(false);
+	if (flare::instrument::snapshot()["getVar"]["tmp_var"].calls != 1){
+		std::cout << "FAILED: temporary label not recorded\n";
+		return 1;
+	}
+	flare::instrument::reset();
+
+	// ioStats of the same variable in two files
+	std::vector<std::string> paths = {"tests/instrument_a.nc", "tests/instrument_b.nc"};
+	for (auto& p : paths) write_file(p);
+	flare::NcFilePP fa, fb;
+	fa.open(paths[0], netCDF::NcFile::read);
+	fa.readMeta();
+	fb.open(paths[1], netCDF::NcFile::read);
+	fb.readMeta();
+	flare::GeoCube<float> a, b;
+	a.readMeta(fa, "x");
+	b.readMeta(fb, "x");
+	flare::instrument::enable(true);
+	a.readBlock(0, 1);
+	b.readBlock(0, 1);
+	b.readBlock(1, 1);
+	flare::instrument::enable(false);
+	for (auto& p : paths) std::remove(p.c_str());
+	if (a.ioStats().calls != 1 || b.ioStats().calls != 2){
+		std::cout << "FAILED: ioStats = " << a.ioStats().calls << " and " << b.ioStats().calls << " calls, expected 1 and 2\n";
+		return 1;
+	}
+	flare::instrument::reset();
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
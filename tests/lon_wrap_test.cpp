@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cstring>
+#include "flare.h"
+
+// (time, lat, lon) = (2, 2, n) file with x = t*1000 + i*100 + j on the given longitudes
+static void write_file(const std::string& path, const std::vector<double>& lons){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time"), latdim = f.addDim("lat", 2), londim = f.addDim("lon", lons.size());
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	std::vector<double> ts = {0, 1}, lats = {-5, 5};
+	std::vector<float> data(2*2*lons.size());
+	for (size_t k=0; k<data.size(); ++k) data[k] = float((k/(2*lons.size()))*1000 + (k/lons.size()%2)*100 + k%lons.size());
+	tvar.putVar(std::vector<size_t>{0}, std::vector<size_t>{2}, ts.data());
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	v.putVar(std::vector<size_t>{0, 0, 0}, std::vector<size_t>{2, 2, lons.size()}, data.data());
+}
+
+// Longitude ranges on periodic grids in both conventions (-165 ... 165 and 15 ... 345, 30 degree steps) and on a
+// regional grid (0 ... 100, 20 degree steps): ranges across the dateline, in the other convention, beyond one
+// period, the full globe with and without halo (more columns than the grid has), bounds at the edge of the grid
+// (which must not wrap), and halos clipped on the regional grid. Each must select the expected columns (on the
+// unrolled axis), with monotonic coordinates in the frame of the lower bound, through setLonBounds and withLonBounds.
+int main(){
+	std::vector<std::string> paths = {"tests/lon_wrap_180.nc", "tests/lon_wrap_360.nc", "tests/lon_wrap_regional.nc"};
+	std::vector<std::vector<double>> grids(3);
+	for (int j=0; j<12; ++j) grids[0].push_back(-165 + 30*j);
+	for (int j=0; j<12; ++j) grids[1].push_back(15 + 30*j);
+	for (int j=0; j<6; ++j)  grids[2].push_back(20*j);
+	for (size_t g=0; g<3; ++g) write_file(paths[g], grids[g]);
+
+	std::vector<flare::NcFilePP> files(3);
+	for (size_t g=0; g<3; ++g){
+		files[g].open(paths[g], netCDF::NcFile::read);
+		files[g].readMeta();
+	}
+
+	// expected: columns first, first+1, ... (mod n) of the grid, with longitudes lon0, lon0 + step, ...
+	struct Query { size_t grid; double lo, hi; size_t halo; long first; size_t count; double lon0; };
+	std::vector<Query> queries = {
+		{0,  170, -170, 0,  11,  2,  165},   // across the dateline
+		{0,  170,  190, 0,  11,  2,  165},   // same, in 0-360 convention
+		{0,  350,  370, 0,   5,  2,  345},   // beyond one period
+		{0, -200, -150, 2,   8,  8, -285},   // beyond the western edge, with halo
+		{0,    0,  360, 0,   6, 12,   15},   // full globe starting at 0
+		{0, -180,  180, 3,  -3, 18, -255},   // full globe with halo: 18 columns on a grid of 12
+		{0, -165,  195, 1,  -1, 14, -195},   // full globe from the first column, with halo
+		{0,   30,   40, 2,   4,  6,  -45},   // ordinary range (no wrap), with halo
+		{0,    0,  180, 0,   5,  7,  -15},   // within half a step of the eastern edge: does not wrap
+		{0, -180,    0, 0,   0,  7, -165},   // within half a step of the western edge: does not wrap
+		{1,  -20,   20, 0,  10,  4,  -45},   // -180 convention on a 0-360 grid
+		{1, -180,  180, 0,   6, 12, -165},   // full globe in -180 convention
+		{2,   10,   50, 3,   0,  6,    0},   // regional grid: halo clipped to the grid
+		{2,  -50,   30, 0,   0,  3,    0},   // regional grid: range beyond the grid clipped
+	};
+
+	int nfail = 0;
+	for (auto& q : queries){
+		auto& x = grids[q.grid];
+		long n = x.size();
+		double step = x[1] - x[0];
+
+		flare::GeoCube<float> v;
+		v.readMeta(files[q.grid], "x");
+		if (v.lon_periodic != (q.grid != 2)){
+			std::cout << "FAILED: periodicity of grid " << q.grid << "\n";
+			return 1;
+		}
+		v.setLonBounds(q.lo, q.hi, q.halo);
+		v.readBlock(1, 1);
+
+		size_t start = v.getStarts()[v.lon_idx], count = v.getCounts()[v.lon_idx];
+		auto& lons = v.coords_trimmed[v.lon_idx];
+		bool ok = (start == size_t(((q.first % n) + n) % n)) && (count == q.count) && lons.size() == count && v.vec.size() == 2*count;
+		for (size_t k=0; ok && k<count; ++k){
+			size_t j = ((q.first + long(k)) % n + n) % n;
+			ok = std::fabs(lons[k] - (q.lon0 + k*step)) < 1e-9 && v.vec[k] == float(1000 + j) && v.vec[count + k] == float(1100 + j);
+		}
+
+		// the same hyperslab through the const read API
+		flare::Hyperslab h = v.withLonBounds(v.hyperslab(), q.lo, q.hi, q.halo);
+		std::vector<float> buf;
+		v.read(h, buf);
+		ok = ok && (h == v.hyperslab()) && buf.size() == v.vec.size() && std::memcmp(buf.data(), v.vec.data(), buf.size()*sizeof(float)) == 0;
+
+		if (!ok){
+			std::cout << "FAILED: lon [" << q.lo << ", " << q.hi << "] with halo " << q.halo << " on grid " << q.grid << " gives " << count
+			          << " columns from " << start << ", expected " << q.count << " from " << q.first << " (lon " << q.lon0 << ")\n";
+			++nfail;
+		}
+	}
+
+	for (auto& f : files) f.close();
+	for (auto& p : paths) std::remove(p.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
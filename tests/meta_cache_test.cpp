@@ -0,0 +1,119 @@
+#include <cstdio>
+#include <fstream>
+#include "flare.h"
+
+// small (time, lat, lon) netCDF file
+static void write_nc(const std::string& path){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time", 2), latdim = f.addDim("lat", 3), londim = f.addDim("lon", 4);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	latvar.putAtt("units", "degrees_north");
+	lonvar.putAtt("units", "degrees_east");
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	std::vector<double> ts = {0, 1}, lats = {-10, 0, 10}, lons = {0, 10, 20, 30};
+	std::vector<float> data(24, 1.f);
+	tvar.putVar(ts.data());
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	v.putVar(data.data());
+}
+
+// Check that cached coordinate metadata is found for an unchanged file, is invalidated
+// when the file changes, and survives a round trip through a sidecar file. Files opened
+// again share their coordinate arrays (with each other and with cubes), and the cache is bounded.
+int main(){
+
+	std::string path = "tests/meta_cache_test.dat";
+	{ std::ofstream f(path); f << "version 1"; }
+
+	auto meta = std::make_shared<flare::CoordMeta>();
+	meta->units["time"] = "days since 2000-01-01";
+	meta->units["lat"] = "degrees_north";
+	meta->values["time"] = std::make_shared<std::vector<double>>(std::vector<double>{0, 1, 2, 3});
+	meta->values["lat"] = std::make_shared<std::vector<double>>(std::vector<double>{-10, 0, 10});
+
+	auto& cache = flare::MetaCache::instance();
+	cache.setSidecarDir("tests");
+
+	auto stamp = flare::FileStamp::of(path);
+	cache.put(stamp, meta);
+
+	auto found = cache.find(flare::FileStamp::of(path));
+	if (!found || found->values.at("time") != meta->values.at("time")){
+		std::cout << "FAILED: cached entry not found (or not shared)\n";
+		return 1;
+	}
+
+	// sidecar: drop the in-process entries and reload
+	cache.clear();
+	found = cache.find(flare::FileStamp::of(path));
+	if (!found || *found->values.at("lat") != *meta->values.at("lat") || found->units.at("time") != meta->units.at("time")){
+		std::cout << "FAILED: sidecar entry not found or different\n";
+		return 1;
+	}
+
+	// changing the file invalidates the entry
+	{ std::ofstream f(path); f << "version 2, longer"; }
+	if (cache.find(flare::FileStamp::of(path))){
+		std::cout << "FAILED: stale entry returned\n";
+		return 1;
+	}
+
+	std::remove(path.c_str());
+	std::remove(("tests/" + std::to_string(std::hash<std::string>()(path)) + ".flaremeta").c_str());
+	cache.setSidecarDir("");
+
+	// ~~ NcFilePP::readMeta: the second open of an unchanged file is served from the cache
+	std::string nc_path = "tests/meta_cache_test.nc";
+	write_nc(nc_path);
+	cache.clear();
+	flare::NcFilePP f1, f2;
+	f1.open(nc_path, netCDF::NcFile::read);
+	f1.readMeta();
+	f2.open(nc_path, netCDF::NcFile::read);
+	f2.readMeta();
+	if (cache.size() != 1 || f2.coordvalues_map.at("lat").shared() != f1.coordvalues_map.at("lat").shared() ||
+	    f2.coordvalues_map.at("lon") != std::vector<double>{0, 10, 20, 30} || f2.coordunits_map.at("lat") != "degrees_north"){
+		std::cout << "FAILED: second readMeta was not served from the cache\n";
+		return 1;
+	}
+
+	// cubes share the file's coordinates until they modify them
+	flare::GeoCube<float> g;
+	g.readMeta(f2, "x");
+	if (g.coords[g.lat_idx].shared() != f1.coordvalues_map.at("lat").shared() || g.coords_trimmed[g.lon_idx].shared() != g.coords[g.lon_idx].shared()){
+		std::cout << "FAILED: cube does not share the coordinates of the file\n";
+		return 1;
+	}
+	g.coords[g.lat_idx].mut()[0] = -99;
+	g.setCoordBounds(g.lon_idx, 10, 20);
+	if (f1.coordvalues_map.at("lat")[0] != -10 || g.coords[g.lat_idx][0] != -99 || f2.coordvalues_map.at("lon").size() != 4){
+		std::cout << "FAILED: modifying the coordinates of a cube changed the cached values\n";
+		return 1;
+	}
+	std::remove(nc_path.c_str());
+
+	// ~~ size bound: the least recently used file is evicted
+	std::vector<std::string> paths = {"tests/meta_cache_test_a.dat", "tests/meta_cache_test_b.dat", "tests/meta_cache_test_c.dat"};
+	for (auto& p : paths){ std::ofstream f(p); f << p; }
+	cache.clear();
+	cache.setMaxEntries(2);
+	cache.put(flare::FileStamp::of(paths[0]), meta);
+	cache.put(flare::FileStamp::of(paths[1]), meta);
+	cache.find(flare::FileStamp::of(paths[0]));        // (a is now more recent than b)
+	cache.put(flare::FileStamp::of(paths[2]), meta);
+	if (cache.size() != 2 || !cache.find(flare::FileStamp::of(paths[0])) || cache.find(flare::FileStamp::of(paths[1])) || !cache.find(flare::FileStamp::of(paths[2]))){
+		std::cout << "FAILED: size bound\n";
+		return 1;
+	}
+	for (auto& p : paths) std::remove(p.c_str());
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+#include <cstdio>
+#include "flare.h"
+
+// write a small (time, lat, lon) file: 4 time steps starting at day t0, values encode (file, time)
+static void write_file(const std::string& path, int file, double t0){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time"), latdim = f.addDim("lat", 3), londim = f.addDim("lon", 4);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	std::vector<double> lats = {-10, 0, 10}, lons = {0, 10, 20, 30};
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	for (size_t t=0; t<4; ++t){
+		double tv = t0 + t;
+		tvar.putVar(std::vector<size_t>{t}, std::vector<size_t>{1}, &tv);
+		std::vector<float> slice(12, float(100*file + t));
+		v.putVar(std::vector<size_t>{t, 0, 0}, std::vector<size_t>{1, 3, 4}, slice.data());
+	}
+}
+
+// Slices of an MFGeoCube served through a SliceCache must come from the right file, also when
+// file handles are closed and reopened (netCDF reuses ncids, and every file has the same local time indices)
+int main(){
+	std::vector<std::string> paths;
+	for (int f=0; f<3; ++f){
+		paths.push_back("tests/mf_cache_" + std::to_string(f) + ".nc");
+		write_file(paths.back(), f, 4*f);
+	}
+
+	flare::MFGeoCube<float> v;
+	v.max_open_files = 1;
+	v.open(paths, "x");
+	flare::SliceCache<float> cache(1024*1024);
+	v.setCache(&cache);
+
+	std::vector<float> buf(v.sliceSize());
+	int nfail = 0;
+	for (int pass=0; pass<2; ++pass){
+		for (size_t t=0; t<12; ++t){
+			v.readSliceInto(t, buf.data());
+			float expected = float(100*(t/4) + t%4);
+			if (buf[0] != expected || buf.back() != expected){
+				std::cout << "FAILED: slice " << t << " (pass " << pass << ") = " << buf[0] << ", expected " << expected << "\n";
+				++nfail;
+			}
+		}
+	}
+	if (cache.stats().hits != 12){
+		std::cout << "FAILED: expected the second pass to be served from the cache\n";
+		++nfail;
+	}
+
+	// a second cube of the same variable in the first file alone must not share the entries
+	flare::NcFilePP in_file;
+	in_file.open(paths[0], netCDF::NcFile::read);
+	in_file.readMeta();
+	flare::GeoCube<float> g;
+	g.readMeta(in_file, "x");
+	if (g.cacheKey(g.getStarts(), g.getCounts()) == v.cacheKey(v.getStarts(), v.getCounts())){
+		std::cout << "FAILED: single-file and multi-file cubes have the same cache key\n";
+		++nfail;
+	}
+
+	for (auto& p : paths) std::remove(p.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+	return 0;
+}
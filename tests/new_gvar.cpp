@@ -16,7 +16,7 @@ int main(){
 	v.print(true);
 
 	// just a test of coord bounding
-	std::reverse(v.coords[v.lat_idx].begin(), v.coords[v.lat_idx].end());
+	std::reverse(v.coords[v.lat_idx].mut().begin(), v.coords[v.lat_idx].mut().end());
 	v.setCoordBounds(v.lon_idx, 75, 101);
 	v.setCoordBounds(v.lat_idx, 60, 80);
 
@@ -25,7 +25,7 @@ int main(){
 
 	v.setCoordBounds(v.lon_idx, 111.25, 131.75);
 	v.setCoordBounds(v.lat_idx, -60.75, 12.25);
-	std::reverse(v.coords[v.lat_idx].begin(), v.coords[v.lat_idx].end());
+	std::reverse(v.coords[v.lat_idx].mut().begin(), v.coords[v.lat_idx].mut().end());
 	// ~~~
 
 	v.setCoordBounds(v.lat_idx, 18.5, 18.5);
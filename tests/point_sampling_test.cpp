@@ -0,0 +1,100 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include "../include/point_sampling.h"
+using namespace std;
+
+int main(){
+	// 1 deg global grid, lat descending (as in many files)
+	vector<double> lats, lons;
+	for (int i=0; i<180; ++i) lats.push_back(89.5 - i);
+	for (int i=0; i<360; ++i) lons.push_back(-179.5 + i);
+	flare::AxisIndex lat_ax(lats), lon_ax(lons);
+
+	// nearest
+	auto s = flare::make_stencil(18.6, 77.2, lats, lat_ax, lons, lon_ax, flare::Sampling::nearest);
+	if (s.n != 1 || lats[s.ilat[0]] != 18.5 || lons[s.ilon[0]] != 77.5){
+		cout << "FAILED: nearest stencil\n";
+		return 1;
+	}
+
+	// bilinear: weights sum to 1 and reproduce a linear function of lat and lon
+	auto f = [&](size_t i, size_t j){ return 2*lats[i] + 3*lons[j]; };
+	s = flare::make_stencil(18.6, 77.2, lats, lat_ax, lons, lon_ax, flare::Sampling::bilinear);
+	double wsum = 0, val = 0;
+	for (int k=0; k<s.n; ++k){ wsum += s.w[k]; val += s.w[k]*f(s.ilat[k], s.ilon[k]); }
+	if (s.n != 4 || fabs(wsum-1) > 1e-12 || fabs(val - (2*18.6 + 3*77.2)) > 1e-9){
+		cout << "FAILED: bilinear stencil (n = " << s.n << ", wsum = " << wsum << ", val = " << val << ")\n";
+		return 1;
+	}
+
+	// points outside the grid are clamped to the edge (on a non-periodic lon axis)
+	s = flare::make_stencil(89.9, 179.9, lats, lat_ax, lons, lon_ax, flare::Sampling::bilinear);
+	if (s.n != 1 || s.ilat[0] != 0 || s.ilon[0] != 359){
+		cout << "FAILED: clamping at grid edge\n";
+		return 1;
+	}
+
+	// on a periodic lon axis, points between the last and the first lon are interpolated across the dateline
+	// (the latitude is still clamped). Longitudes may be given in either convention.
+	struct Query { double lon; size_t ilon_w; double w; };  // expected weight w of column ilon_w (the rest on the other side)
+	for (auto q : vector<Query>{{179.9, 359, 0.6}, {-179.9, 0, 0.6}, {180.1, 0, 0.6}, {-180.25, 359, 0.75}, {539.9, 359, 0.6}}){
+		s = flare::make_stencil(89.9, q.lon, lats, lat_ax, lons, lon_ax, flare::Sampling::bilinear, true);
+		double w = 0, wsum = 0;
+		for (int k=0; k<s.n; ++k){
+			if (s.ilat[k] != 0 || (s.ilon[k] != 0 && s.ilon[k] != 359)){ w = -1; break; }
+			if (s.ilon[k] == q.ilon_w) w += s.w[k];
+			wsum += s.w[k];
+		}
+		if (s.n != 2 || fabs(w - q.w) > 1e-9 || fabs(wsum - 1) > 1e-12){
+			cout << "FAILED: periodic bilinear stencil at lon " << q.lon << " (n = " << s.n << ", w = " << w << ")\n";
+			return 1;
+		}
+	}
+
+	// the same on a 0...360 grid with lon descending, and nearest neighbours across the edge
+	vector<double> lons_desc;
+	for (int i=0; i<360; ++i) lons_desc.push_back(359.5 - i);
+	flare::AxisIndex lon_desc_ax(lons_desc);
+	s = flare::make_stencil(0, -0.2, lats, lat_ax, lons_desc, lon_desc_ax, flare::Sampling::bilinear, true);
+	val = 0;
+	for (int k=0; k<s.n; ++k) val += s.w[k]*lons_desc[s.ilon[k]];
+	if (s.n != 4 || fabs(val - (0.7*359.5 + 0.3*0.5)) > 1e-9){
+		cout << "FAILED: periodic bilinear stencil on a descending grid\n";
+		return 1;
+	}
+	auto sn = flare::make_stencil(0, 0.1, lats, lat_ax, lons_desc, lon_desc_ax, flare::Sampling::nearest, true);
+	auto sw = flare::make_stencil(0, -0.1, lats, lat_ax, lons_desc, lon_desc_ax, flare::Sampling::nearest, true);
+	if (lons_desc[sn.ilon[0]] != 0.5 || lons_desc[sw.ilon[0]] != 359.5){
+		cout << "FAILED: periodic nearest neighbour\n";
+		return 1;
+	}
+
+	// plan: 3 points, two of which share a 10x10 tile
+	vector<flare::PointStencil> stencils = {
+		flare::make_stencil(18.6, 77.2, lats, lat_ax, lons, lon_ax, flare::Sampling::nearest),
+		flare::make_stencil(15.1, 75.0, lats, lat_ax, lons, lon_ax, flare::Sampling::nearest),
+		flare::make_stencil(-30, 20, lats, lat_ax, lons, lon_ax, flare::Sampling::nearest),
+		flare::make_stencil(18.6, 77.2, lats, lat_ax, lons, lon_ax, flare::Sampling::nearest), // duplicate
+	};
+	flare::PointReadPlan plan(stencils, 10, 10);
+	cout << "cells = " << plan.cells.size() << ", tiles = " << plan.tiles.size() << "\n";
+	if (plan.cells.size() != 3 || plan.tiles.size() != 2 || plan.point_cells[3][0] != plan.point_cells[0][0]){
+		cout << "FAILED: read plan\n";
+		return 1;
+	}
+	for (auto& t : plan.tiles){
+		for (auto c : t.cells){
+			auto cell = plan.cells[c];
+			if (cell.first < t.lat0 || cell.first >= t.lat0+t.nlat || cell.second < t.lon0 || cell.second >= t.lon0+t.nlon){
+				cout << "FAILED: cell outside tile bounding box\n";
+				return 1;
+			}
+		}
+	}
+
+	cout << "-----------------\n";
+	cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include "flare.h"
+
+// Check that prefetched slices are identical to those read directly via readBlock
+int main(){
+
+	flare::NcFilePP in_file;
+	in_file.open("tests/data/gpp.2000-2015.nc", netCDF::NcFile::read);
+	in_file.readMeta();
+
+	flare::GeoCube<float> v, v_ref;
+	v.readMeta(in_file);
+	v_ref.readMeta(in_file);
+
+	v.setCoordBounds(v.lon_idx, 70, 80);
+	v.setCoordBounds(v.lat_idx, 15, 25);
+	v_ref.setCoordBounds(v_ref.lon_idx, 70, 80);
+	v_ref.setCoordBounds(v_ref.lat_idx, 15, 25);
+
+	flare::Prefetcher<float> reader(v, 1.0, true, true);
+
+	double t0 = flare::datestring_to_julian("2000-01-01 00:00:00");
+	for (double t = t0; t < t0+400; t += 1){
+		reader.read(t);
+		v_ref.readBlock(t, true, true);
+
+		if (v.vec.size() != v_ref.vec.size()){
+			std::cout << "FAILED: size mismatch on " << flare::julian_to_datestring(t) << "\n";
+			return 1;
+		}
+		for (size_t i=0; i<v.vec.size(); ++i){
+			if (v.vec[i] != v_ref.vec[i] && !(std::isnan(v.vec[i]) && std::isnan(v_ref.vec[i]))){
+				std::cout << "FAILED: value mismatch on " << flare::julian_to_datestring(t) << "\n";
+				return 1;
+			}
+		}
+		// swapped-in slices update the hyperslab as readBlock does
+		if (v.getStarts() != v_ref.getStarts() || v.getCounts() != v_ref.getCounts()){
+			std::cout << "FAILED: hyperslab mismatch on " << flare::julian_to_datestring(t) << "\n";
+			return 1;
+		}
+	}
+
+	// unpacked on read, and past the end of the data without periodic extension (no next index to prefetch)
+	flare::GeoCube<float> u, u_ref;
+	for (auto* c : {&u, &u_ref}){
+		c->readMeta(in_file);
+		c->setCoordBounds(c->lon_idx, 70, 80);
+		c->setCoordBounds(c->lat_idx, 15, 25);
+		c->unpack_on_read = true;
+	}
+	{
+		flare::Prefetcher<float> unpacked(u, 1.0, false, true);
+		double t_end = u.t_index_to_julian(u.getCounts()[u.t_idx] - 1);
+		for (double t = t_end - 40; t < t_end + 40; t += 1){
+			unpacked.read(t);
+			u_ref.readBlock(t, false, true);
+			if (u.vec.size() != u_ref.vec.size() || !std::equal(u.vec.begin(), u.vec.end(), u_ref.vec.begin(), [](float a, float b){ return a == b || (std::isnan(a) && std::isnan(b)); })){
+				std::cout << "FAILED: value mismatch near the end of the data on " << flare::julian_to_datestring(t) << "\n";
+				return 1;
+			}
+			if (u.getStarts() != u_ref.getStarts() || !std::isnan(u.missing_value)){
+				std::cout << "FAILED: hyperslab or missing value of unpacked slice on " << flare::julian_to_datestring(t) << "\n";
+				return 1;
+			}
+		}
+	}
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+#include <iostream>
+#include <vector>
+#include "../include/read_plan.h"
+using namespace std;
+
+int main(){
+	// (time, lat, lon) variable with chunks of 10 x 90 x 180, float
+	flare::StorageLayout layout;
+	layout.chunked = true;
+	layout.chunks = {10, 90, 180};
+	layout.elem_size = 4;
+
+	// one time slice over a window that cuts across chunks in lat and lon
+	vector<size_t> starts = {5, 80, 170}, counts = {1, 20, 20};
+	vector<ptrdiff_t> strides = {1, 1, 1};
+	auto plan = flare::make_read_plan(layout, starts, counts, strides, sizeof(float));
+	plan.print();
+	if (plan.chunks_touched != 4 || plan.bytes_delivered != 20*20*4 || plan.bytes_decompressed != 4*layout.chunk_bytes() || plan.sub_starts.size() != 1){
+		cout << "FAILED: plan for a single slice\n";
+		return 1;
+	}
+
+	// a block of 95 time steps, split into chunk-aligned pieces of at most ~3 chunk rows
+	starts = {5, 0, 0};
+	counts = {95, 90, 180};
+	size_t row_bytes = 90*180*4;
+	plan = flare::make_read_plan(layout, starts, counts, strides, sizeof(float), 30*row_bytes);
+	plan.print();
+
+	size_t next = starts[0];
+	for (size_t i=0; i<plan.sub_starts.size(); ++i){
+		size_t s = plan.sub_starts[i][0], c = plan.sub_counts[i][0];
+		if (s != next || plan.sub_offsets[i] != (s-starts[0])*90*180){
+			cout << "FAILED: sub-reads are not contiguous\n";
+			return 1;
+		}
+		if ((s+c) % 10 != 0 && s+c != starts[0]+counts[0]){
+			cout << "FAILED: sub-read does not end on a chunk boundary\n";
+			return 1;
+		}
+		if (c*row_bytes > 30*row_bytes){
+			cout << "FAILED: sub-read larger than max_read_bytes\n";
+			return 1;
+		}
+		next = s+c;
+	}
+	if (next != starts[0]+counts[0]){
+		cout << "FAILED: sub-reads do not cover the block\n";
+		return 1;
+	}
+
+	cout << "-----------------\n";
+	cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <atomic>
+#include "flare.h"
+
+// small (time, lat, lon) file with a variable x = k*1000 + t*100 + cell
+static void write_file(const std::string& path, int k){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time", 4), latdim = f.addDim("lat", 3), londim = f.addDim("lon", 5);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	std::vector<double> ts = {0, 1, 2, 3}, lats = {-10, 0, 10}, lons = {0, 10, 20, 30, 40};
+	std::vector<float> data(60);
+	for (size_t i=0; i<data.size(); ++i) data[i] = float(k*1000 + (i/15)*100 + i%15);
+	tvar.putVar(ts.data());
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	v.putVar(data.data());
+}
+
+// ThreadPool tasks return their results and exceptions through futures, and parallel_for covers
+// the whole range; ReaderGroup gives the same data as reading the cubes one by one, and rethrows
+// a failed read only after all other reads completed.
+int main(){
+	int nfail = 0;
+
+	// ~~ ThreadPool
+	{
+		flare::ThreadPool pool(3);
+		std::vector<int> hits(1000, 0);
+		pool.parallel_for(hits.size(), [&](size_t b, size_t e){ for (size_t i=b; i<e; ++i) ++hits[i]; });
+		if (std::count(hits.begin(), hits.end(), 1) != 1000){
+			std::cout << "FAILED: parallel_for did not visit every index exactly once\n";
+			++nfail;
+		}
+
+		std::atomic<int> done{0};
+		auto ok = pool.submit([&](){ ++done; });
+		auto bad = pool.submit([&](){ ++done; throw std::runtime_error("task error"); });
+		ok.get();
+		try{
+			bad.get();
+			std::cout << "FAILED: exception of a task was not propagated\n";
+			++nfail;
+		}
+		catch(std::runtime_error& e){
+			if (std::string(e.what()) != "task error"){
+				std::cout << "FAILED: wrong exception propagated: " << e.what() << "\n";
+				++nfail;
+			}
+		}
+
+		std::atomic<size_t> covered{0};
+		try{
+			pool.parallel_for(30, [&](size_t b, size_t e){
+				covered += e-b;
+				if (b == 0) throw std::runtime_error("range error");
+			});
+			std::cout << "FAILED: exception in parallel_for was not propagated\n";
+			++nfail;
+		}
+		catch(std::runtime_error&){}
+		if (covered != 30 || done != 2){
+			std::cout << "FAILED: tasks did not all complete (" << covered << " of 30 indices, " << done << " of 2 tasks)\n";
+			++nfail;
+		}
+	}
+
+	// ~~ ReaderGroup over cubes in three files
+	std::vector<std::string> paths = {"tests/reader_group_0.nc", "tests/reader_group_1.nc", "tests/reader_group_2.nc"};
+	for (size_t k=0; k<paths.size(); ++k) write_file(paths[k], k);
+	std::vector<flare::NcFilePP> files(paths.size());
+	std::vector<flare::GeoCube<float>> cubes(paths.size()), refs(paths.size());
+	for (size_t k=0; k<paths.size(); ++k){
+		files[k].open(paths[k], netCDF::NcFile::read);
+		files[k].readMeta();
+		cubes[k].readMeta(files[k], "x");
+		refs[k].readMeta(files[k], "x");
+		cubes[k].setCoordBounds(cubes[k].lon_idx, 5, 35);
+		refs[k].setCoordBounds(refs[k].lon_idx, 5, 35);
+	}
+
+	flare::ReaderGroup<float> group(2);
+	for (auto& c : cubes) group.add(c);
+	for (size_t t=0; t<4; t+=2){
+		group.readBlock(t, 2);
+		for (size_t k=0; k<paths.size(); ++k){
+			refs[k].readBlock(t, 2);
+			if (cubes[k].vec != refs[k].vec || cubes[k].vec.size() != 18 || cubes[k].vec[0] != float(k*1000 + t*100 + 1)){
+				std::cout << "FAILED: ReaderGroup data of cube " << k << " at t = " << t << "\n";
+				++nfail;
+			}
+		}
+	}
+
+	// the second cube reads past the end of the lat axis: the error reaches the caller, and the other cubes are still read
+	cubes[1].setIndices(cubes[1].lat_idx, 2, 3);
+	for (auto& c : cubes) std::fill(c.vec.begin(), c.vec.end(), -1.f);
+	flare::ReaderGroup<float> failing({&cubes[0], &cubes[1], &cubes[2]}, 1);
+	bool thrown = false;
+	try{
+		failing.readBlock(1, 1);
+	}
+	catch(std::exception&){ thrown = true; }
+	if (!thrown){
+		std::cout << "FAILED: read error in ReaderGroup was not propagated\n";
+		++nfail;
+	}
+	for (size_t k : {0, 2}){
+		if (cubes[k].vec.size() != 9 || cubes[k].vec[0] != float(k*1000 + 100 + 1)){
+			std::cout << "FAILED: cube " << k << " not read after an error in another cube\n";
+			++nfail;
+		}
+	}
+
+	for (auto& f : files) f.close();
+	for (auto& p : paths) std::remove(p.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+	return 0;
+}
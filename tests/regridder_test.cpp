@@ -0,0 +1,104 @@
+#include <cstdio>
+#include "flare.h"
+
+// Check regridding weights: rows sum to 1, bilinear reproduces fields linear in lat and lon,
+// conservative regridding preserves the area-weighted mean and does not wrap regional grids, missing values
+// are skipped, and weights survive a save/load round trip
+int main(){
+
+	auto axis = [](double x0, double dx, size_t n){
+		std::vector<double> x(n);
+		for (size_t i=0; i<n; ++i) x[i] = x0 + i*dx;
+		return x;
+	};
+
+	// 1 deg source grid (0..359 lons, descending lats) --> 2.5 deg destination grid (-180..180 lons)
+	std::vector<double> src_lats = axis(89.5, -1, 180), src_lons = axis(0.5, 1, 360);
+	std::vector<double> dst_lats = axis(-88.75, 2.5, 72), dst_lons = axis(-178.75, 2.5, 144);
+
+	std::vector<double> src(src_lats.size()*src_lons.size());
+
+	// --- bilinear
+	flare::Regridder bil(src_lats, src_lons, dst_lats, dst_lons, flare::RegridMethod::bilinear);
+	for (size_t i=0; i<bil.weights.nrows; ++i){
+		double s = 0;
+		for (size_t k=bil.weights.row_ptr[i]; k<bil.weights.row_ptr[i+1]; ++k) s += bil.weights.w[k];
+		if (std::fabs(s-1) > 1e-12){
+			std::cout << "FAILED: bilinear weights of row " << i << " sum to " << s << "\n";
+			return 1;
+		}
+	}
+
+	// field linear in lat, and in lon away from the 0/360 seam
+	for (size_t i=0; i<src_lats.size(); ++i) for (size_t j=0; j<src_lons.size(); ++j) src[i*src_lons.size()+j] = 2*src_lats[i] + src_lons[j];
+	std::vector<double> dst(dst_lats.size()*dst_lons.size());
+	bil.apply(src.data(), dst.data(), -999.0);
+	for (size_t i=1; i<dst_lats.size()-1; ++i){
+		for (size_t j=0; j<dst_lons.size(); ++j){
+			double lon = dst_lons[j] < 0? dst_lons[j]+360 : dst_lons[j];
+			if (lon < 1 || lon > 359) continue;
+			if (std::fabs(dst[i*dst_lons.size()+j] - (2*dst_lats[i] + lon)) > 1e-9){
+				std::cout << "FAILED: bilinear at (" << dst_lats[i] << ", " << dst_lons[j] << ") = " << dst[i*dst_lons.size()+j] << "\n";
+				return 1;
+			}
+		}
+	}
+
+	// --- conservative
+	flare::ThreadPool pool(4);
+	flare::Regridder con(src_lats, src_lons, dst_lats, dst_lons, flare::RegridMethod::conservative);
+	for (size_t i=0; i<src_lats.size(); ++i) for (size_t j=0; j<src_lons.size(); ++j) src[i*src_lons.size()+j] = std::sin(3*src_lats[i]*M_PI/180)*std::cos(2*src_lons[j]*M_PI/180) + 1;
+	con.apply(src.data(), dst.data(), -999.0, &pool);
+
+	auto area_mean = [](const std::vector<double>& f, const std::vector<double>& lats, double dlat, size_t nlon){
+		double s = 0, a = 0;
+		for (size_t i=0; i<lats.size(); ++i){
+			double w = std::sin((lats[i]+dlat/2)*M_PI/180) - std::sin((lats[i]-dlat/2)*M_PI/180);
+			for (size_t j=0; j<nlon; ++j){ s += std::fabs(w)*f[i*nlon+j]; a += std::fabs(w); }
+		}
+		return s/a;
+	};
+	double m_src = area_mean(src, src_lats, 1, src_lons.size());
+	double m_dst = area_mean(dst, dst_lats, 2.5, dst_lons.size());
+	if (std::fabs(m_src - m_dst) > 1e-10){
+		std::cout << "FAILED: conservative regridding changed the mean: " << m_src << " --> " << m_dst << "\n";
+		return 1;
+	}
+
+	// missing values are skipped
+	std::fill(src.begin(), src.end(), 5.0);
+	for (size_t j=0; j<src_lons.size(); j+=2) src[j] = -999;
+	con.apply(src.data(), dst.data(), -999.0);
+	for (double v : dst){
+		if (v != 5.0 && std::fabs(v-5) > 1e-12){
+			std::cout << "FAILED: missing values not skipped (" << v << ")\n";
+			return 1;
+		}
+	}
+
+	// a regional source grid (0 ... 20 E) does not wrap: destination cells beyond 360 E get no weights
+	{
+		std::vector<double> reg_lons = axis(0.5, 1, 20), far_lons = axis(358.75, 2.5, 2), lats = axis(-0.5, 1, 2);
+		flare::Regridder reg(lats, reg_lons, lats, far_lons, flare::RegridMethod::conservative);
+		if (reg.weights.nnz() != 0){
+			std::cout << "FAILED: regional grid wrapped around in conservative regridding (" << reg.weights.nnz() << " weights)\n";
+			return 1;
+		}
+	}
+
+	// --- save / load
+	con.save("tests/regrid_weights.bin");
+	flare::Regridder con2 = con;
+	con2.weights = flare::SparseWeights();
+	con2.load("tests/regrid_weights.bin");
+	std::remove("tests/regrid_weights.bin");
+	if (con2.weights.row_ptr != con.weights.row_ptr || con2.weights.col != con.weights.col || con2.weights.w != con.weights.w){
+		std::cout << "FAILED: weights differ after save/load\n";
+		return 1;
+	}
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
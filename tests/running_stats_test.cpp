@@ -0,0 +1,49 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <numeric>
+#include "../include/temporal_reducer.h"
+using namespace std;
+
+int main(){
+	// running statistics must match two-pass statistics
+	vector<double> x = {3.2, -1.5, 8.0, 4.4, 4.4, 10.1, -7.3, 0.0, 2.5};
+	flare::RunningStats s(1);
+	for (auto v : x) s.add(0, v);
+
+	double mean = accumulate(x.begin(), x.end(), 0.0)/x.size();
+	double var = 0;
+	for (auto v : x) var += (v-mean)*(v-mean);
+	var /= x.size();
+
+	cout << "mean = " << s.mean[0] << " (" << mean << "), var = " << s.m2[0]/s.n[0] << " (" << var << ")\n";
+	if (fabs(s.mean[0]-mean) > 1e-12 || fabs(s.m2[0]/s.n[0] - var) > 1e-12 || s.n[0] != x.size() ||
+	    s.min[0] != -7.3 || s.max[0] != 10.1 || fabs(s.sum[0] - mean*x.size()) > 1e-12){
+		cout << "FAILED: running stats\n";
+		return 1;
+	}
+
+	// grouping keys
+	std::tm d = flare::julian_to_date(flare::datestring_to_julian("2003-03-15 12:00:00"));
+	if (flare::period_key(d, flare::Period::year) != 2003 ||
+	    flare::period_key(d, flare::Period::month) != 200303 ||
+	    flare::period_key(d, flare::Period::month_of_year) != 3 ||
+	    flare::period_key(d, flare::Period::day_of_year) != 315 ||
+	    flare::period_key(d, flare::Period::all) != 0){
+		cout << "FAILED: period keys\n";
+		return 1;
+	}
+
+	// a calendar day has the same day-of-year key in leap and non-leap years
+	std::tm leap = flare::julian_to_date(flare::datestring_to_julian("2004-03-15 00:00:00"));
+	std::tm feb29 = flare::julian_to_date(flare::datestring_to_julian("2004-02-29 00:00:00"));
+	if (flare::period_key(leap, flare::Period::day_of_year) != 315 || flare::period_key(feb29, flare::Period::day_of_year) != 229){
+		cout << "FAILED: day-of-year keys in a leap year\n";
+		return 1;
+	}
+
+	cout << "-----------------\n";
+	cout << "All tests PASSED!\n";
+
+	return 0;
+}
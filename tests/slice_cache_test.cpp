@@ -0,0 +1,51 @@
+#include <iostream>
+#include <vector>
+#include "../include/slice_cache.h"
+using namespace std;
+
+int main(){
+	// budget for 3 slices of 100 floats
+	flare::SliceCache<float> cache(3*100*sizeof(float));
+
+	vector<float> a(100, 1.f), b(100, 2.f), c(100, 3.f), d(100, 4.f), out(100);
+
+	cache.put("a", a.data(), a.size());
+	cache.put("b", b.data(), b.size());
+	cache.put("c", c.data(), c.size());
+
+	// touch a, so that b becomes least recently used
+	if (!cache.get("a", out.data(), out.size()) || out[0] != 1.f){
+		cout << "FAILED: expected hit on a\n";
+		return 1;
+	}
+
+	// inserting d must evict b
+	cache.put("d", d.data(), d.size());
+	if (cache.get("b", out.data(), out.size())){
+		cout << "FAILED: b should have been evicted\n";
+		return 1;
+	}
+	if (!cache.get("c", out.data(), out.size()) || out[0] != 3.f){
+		cout << "FAILED: expected hit on c\n";
+		return 1;
+	}
+
+	auto s = cache.stats();
+	cache.print_stats();
+	if (s.hits != 2 || s.misses != 1 || s.evictions != 1 || s.entries != 3 || s.bytes_used != 300*sizeof(float)){
+		cout << "FAILED: unexpected stats\n";
+		return 1;
+	}
+
+	// shrinking the budget evicts least recently used entries
+	cache.setBudget(100*sizeof(float));
+	if (cache.stats().entries != 1 || !cache.get("c", out.data(), out.size())){
+		cout << "FAILED: setBudget did not keep the most recent entry\n";
+		return 1;
+	}
+
+	cout << "-----------------\n";
+	cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cstring>
+#include "flare.h"
+
+// small (time, lat, lon) = (4, 3, 5) file with x = t*100 + i*10 + j, in the given format
+static void write_file(const std::string& path, netCDF::NcFile::FileFormat format){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, format);
+	netCDF::NcDim tdim = f.addDim("time"), latdim = f.addDim("lat", 3), londim = f.addDim("lon", 5);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2000-01-01 00:00:00");
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	std::vector<double> ts = {0, 1, 2, 3}, lats = {-10, 0, 10}, lons = {0, 10, 20, 30, 40};
+	std::vector<float> data(60);
+	for (size_t k=0; k<data.size(); ++k) data[k] = float((k/15)*100 + (k/5%3)*10 + k%5);
+	tvar.putVar(std::vector<size_t>{0}, std::vector<size_t>{4}, ts.data());
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	v.putVar(std::vector<size_t>{0, 0, 0}, std::vector<size_t>{4, 3, 5}, data.data());
+}
+
+static int64_t file_size(const std::string& path){
+	return flare::FileStamp::of(path).size;
+}
+
+// Files staged in memory (RAM copy or mapping, chosen explicitly or by the size threshold) must give the same
+// metadata and data as the file on disk, in netCDF-4 and classic format, even after the file on disk is removed.
+// Files are staged only when read-only and strictly below the threshold, and reopening releases the image.
+int main(){
+	using Staging = flare::NcFilePP::Staging;
+	std::vector<std::string> paths = {"tests/staging_nc4.nc", "tests/staging_classic.nc"};
+	write_file(paths[0], netCDF::NcFile::nc4);
+	write_file(paths[1], netCDF::NcFile::classic);
+
+	// window lon [12, 28] (with the bracketing columns: 1..3), t = 1..2, checked against the values written
+	auto check_window = [](flare::NcFilePP& f, const std::string& what){
+		f.readMeta();
+		flare::GeoCube<float> v;
+		v.readMeta(f, "x");
+		v.setCoordBounds(v.lon_idx, 12, 28);
+		v.readBlock(1, 2);
+		bool ok = v.vec.size() == 18 && v.coords_trimmed[v.lon_idx] == std::vector<double>{10, 20, 30}
+		          && v.coords[v.lat_idx] == std::vector<double>{-10, 0, 10};
+		for (size_t k=0; ok && k<v.vec.size(); ++k) ok = (v.vec[k] == float((1 + k/9)*100 + (k/3%3)*10 + 1 + k%3));
+		if (!ok){
+			std::cout << "FAILED: " << what << ": wrong data or coordinates\n";
+			return 1;
+		}
+		return 0;
+	};
+
+	struct Query { size_t file; Staging staging; bool remove_from_disk; };
+	std::vector<Query> queries = {
+		{0, Staging::none, false},
+		{0, Staging::ram,  false},
+		{0, Staging::mmap, false},
+		{1, Staging::ram,  false},
+		{1, Staging::mmap, false},
+		{0, Staging::ram,  true},   // the image does not depend on the file on disk
+		{1, Staging::mmap, true},   // (a mapping outlives the removal of the file)
+	};
+
+	auto name = [](Staging s){
+		return (s == Staging::ram)? "ram" : (s == Staging::mmap)? "mmap" : (s == Staging::none)? "none" : "automatic";
+	};
+
+	int nfail = 0;
+	for (auto& q : queries){
+		std::string path = paths[q.file], what = path + " (staging: " + name(q.staging) + ")";
+		int64_t size = file_size(path);
+
+		flare::NcFilePP f;
+		f.open(path, netCDF::NcFile::read, q.staging);
+		bool staged = (q.staging != Staging::none);
+		if (f.staged() != staged || f.stagedBytes() != (staged? size_t(size) : 0)){
+			std::cout << "FAILED: " << what << ": " << f.stagedBytes() << " bytes staged, file has " << size << "\n";
+			++nfail;
+		}
+		if (q.remove_from_disk) std::remove(path.c_str());
+		nfail += check_window(f, what);
+
+		// a staged file is never read through the chunk reader (which reads from the file on disk)
+		flare::ThreadPool pool(1);
+		flare::GeoCube<float> v;
+		v.readMeta(f, "x");
+		if (staged && v.setDecompressionPool(&pool)){
+			std::cout << "FAILED: " << what << ": chunk reader set up for a staged file\n";
+			++nfail;
+		}
+
+		f.close();
+		if (f.staged() || f.stagedBytes() != 0){
+			std::cout << "FAILED: " << what << ": image not released on close\n";
+			++nfail;
+		}
+	}
+	write_file(paths[0], netCDF::NcFile::nc4);   // (removed above)
+	write_file(paths[1], netCDF::NcFile::classic);
+
+	// size threshold: only files strictly smaller than the threshold are staged, never with threshold 0
+	int64_t size = file_size(paths[0]);
+	for (auto t : std::vector<std::pair<size_t, bool>>{{0, false}, {size_t(size), false}, {size_t(size) + 1, true}}){
+		flare::NcFilePP::stage_threshold = t.first;
+		flare::NcFilePP f;
+		f.open(paths[0], netCDF::NcFile::read);
+		if (f.staged() != t.second){
+			std::cout << "FAILED: file of " << size << " bytes " << (f.staged()? "staged" : "not staged") << " with threshold " << t.first << "\n";
+			++nfail;
+		}
+		nfail += check_window(f, "automatic staging with threshold " + std::to_string(t.first));
+	}
+
+	// files opened for writing are never staged
+	{
+		flare::NcFilePP f;
+		f.open(paths[0], netCDF::NcFile::write, Staging::ram);
+		if (f.staged()){ std::cout << "FAILED: file opened for writing was staged\n"; ++nfail; }
+	}
+	flare::NcFilePP::stage_threshold = 0;
+
+	// missing files are errors, whatever the staging mode
+	for (Staging s : {Staging::none, Staging::ram, Staging::mmap}){
+		flare::NcFilePP f;
+		try{
+			f.open("tests/staging_missing.nc", netCDF::NcFile::read, s);
+			std::cout << "FAILED: missing file opened with staging " << name(s) << "\n";
+			++nfail;
+		}
+		catch(std::exception&){}
+	}
+
+	// reopening a staged file from disk (through any open overload) releases its image
+	{
+		flare::NcFilePP f;
+		f.open(paths[0], netCDF::NcFile::read, Staging::ram);
+		f.open(paths[0], netCDF::NcFile::read);
+		if (f.staged() || f.stagedBytes() != 0){ std::cout << "FAILED: image kept after reopening from disk\n"; ++nfail; }
+		f.open(paths[0], netCDF::NcFile::read, Staging::mmap);
+		f.open(paths[0], netCDF::NcFile::read, netCDF::NcFile::nc4);
+		if (f.staged()){ std::cout << "FAILED: image kept after reopening with a file format\n"; ++nfail; }
+		nfail += check_window(f, "reopened file");
+	}
+
+	for (auto& p : paths) std::remove(p.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\nAll tests PASSED!\n";
+	return 0;
+}
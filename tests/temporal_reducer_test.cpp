@@ -0,0 +1,159 @@
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include "flare.h"
+
+// daily (time, lat, lon) file from 2003-01-01 (in the given calendar): x = t + cell, with cell 1 missing on even days
+static void write_file(const std::string& path, size_t nt, const std::string& calendar = ""){
+	netCDF::NcFile f(path, netCDF::NcFile::replace, netCDF::NcFile::nc4);
+	netCDF::NcDim tdim = f.addDim("time"), latdim = f.addDim("lat", 2), londim = f.addDim("lon", 3);
+	netCDF::NcVar tvar = f.addVar("time", netCDF::ncDouble, tdim);
+	netCDF::NcVar latvar = f.addVar("lat", netCDF::ncDouble, latdim);
+	netCDF::NcVar lonvar = f.addVar("lon", netCDF::ncDouble, londim);
+	tvar.putAtt("units", "days since 2003-01-01 00:00:00");
+	if (!calendar.empty()) tvar.putAtt("calendar", calendar);
+	netCDF::NcVar v = f.addVar("x", netCDF::ncFloat, std::vector<netCDF::NcDim>{tdim, latdim, londim});
+	v.putAtt("units", "1");
+	v.putAtt("missing_value", netCDF::ncFloat, -999.f);
+	std::vector<double> lats = {-10, 10}, lons = {0, 10, 20};
+	latvar.putVar(lats.data());
+	lonvar.putVar(lons.data());
+	for (size_t t=0; t<nt; ++t){
+		double tv = t;
+		tvar.putVar(std::vector<size_t>{t}, std::vector<size_t>{1}, &tv);
+		std::vector<float> slice(6);
+		for (size_t c=0; c<6; ++c) slice[c] = (c == 1 && t%2 == 0)? -999.f : float(t + c);
+		v.putVar(std::vector<size_t>{t, 0, 0}, std::vector<size_t>{1, 2, 3}, slice.data());
+	}
+}
+
+struct Expected {
+	double sum[6] = {0};
+	int n[6] = {0};
+};
+
+// date of day t since 2003-01-01: Gregorian, or in a year of 12 months of 30 days, or of 365 days without leap years
+static void date_of(size_t t, const std::string& calendar, int& y, int& m, int& d){
+	if (calendar == "360_day"){
+		y = 2003 + t/360; m = (t%360)/30 + 1; d = t%30 + 1;
+	}
+	else if (calendar == "noleap"){
+		static const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+		int doy = t%365;
+		y = 2003 + t/365; m = 1;
+		while (doy >= mdays[m-1]) doy -= mdays[m++ - 1];
+		d = doy + 1;
+	}
+	else {
+		std::tm date = flare::julian_to_date(flare::datestring_to_julian("2003-01-01 00:00:00") + t);
+		y = date.tm_year + 1900; m = date.tm_mon + 1; d = date.tm_mday;
+	}
+}
+
+// expected sums and counts per group, computed directly from the dates of the time steps
+static std::map<long, Expected> expected(size_t nt, flare::Period period, const std::string& calendar = ""){
+	std::map<long, Expected> e;
+	for (size_t t=0; t<nt; ++t){
+		int y, m, d;
+		date_of(t, calendar, y, m, d);
+		Expected& g = e[flare::period_key(y, m, d, period)];
+		for (size_t c=0; c<6; ++c){
+			if (c == 1 && t%2 == 0) continue;
+			g.sum[c] += t + c;
+			++g.n[c];
+		}
+	}
+	return e;
+}
+
+static int check(const std::string& what, long key, const flare::TemporalReducer<float>& r, const Expected& e){
+	auto mean = r.mean(key);
+	auto n = r.count(key);
+	for (size_t c=0; c<6; ++c){
+		if (n.vec[c] != e.n[c] || std::fabs(mean.vec[c] - e.sum[c]/e.n[c]) > 1e-9){
+			std::cout << "FAILED: " << what << " group " << key << " cell " << c << ": mean " << mean.vec[c] << " (n = " << n.vec[c]
+			          << "), expected " << e.sum[c]/e.n[c] << " (n = " << e.n[c] << ")\n";
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// TemporalReducer over blocks that straddle group boundaries (7-day blocks), with streamed monthly
+// groups, a daily climatology over a leap year, and monthly groups on 360_day and noleap calendars
+int main(){
+	std::string path = "tests/temporal_reducer.nc";
+	size_t nt = 800; // 2003-01-01 ... 2005-03-11
+	write_file(path, nt);
+
+	flare::NcFilePP in_file;
+	in_file.open(path, netCDF::NcFile::read);
+	in_file.readMeta();
+	flare::GeoCube<float> cube;
+	cube.readMeta(in_file, "x");
+
+	int nfail = 0;
+
+	// ~~ monthly means, handed out as each month closes
+	auto e_month = expected(nt, flare::Period::month);
+	std::vector<long> closed;
+	size_t max_held = 0;
+	flare::TemporalReducer<float> monthly(flare::Period::month, [&](long key, const flare::TemporalReducer<float>& r){
+		closed.push_back(key);
+		max_held = std::max(max_held, r.groups.size());
+		nfail += check("monthly", key, r, e_month[key]);
+	});
+	monthly.accumulate(cube, 0, 500, 7);
+	monthly.accumulate(cube, 500, nt-500, 7); // (a month spans the two calls)
+	monthly.finish();
+
+	std::vector<long> keys;
+	for (auto& g : e_month) keys.push_back(g.first);
+	if (closed != keys){
+		std::cout << "FAILED: " << closed.size() << " monthly groups closed, expected " << keys.size() << " in order\n";
+		++nfail;
+	}
+	if (max_held != 1 || !monthly.groups.empty()){
+		std::cout << "FAILED: closed groups are not freed (up to " << max_held << " held)\n";
+		++nfail;
+	}
+
+	// ~~ daily climatology: all groups are kept; Mar 1 is one group in 2003, 2004 (leap) and 2005
+	auto e_day = expected(nt, flare::Period::day_of_year);
+	flare::TemporalReducer<float> daily(flare::Period::day_of_year);
+	daily.accumulate(cube, 0, nt, 7);
+	if (daily.keys().size() != 366 || e_day[301].n[0] != 3 || e_day[229].n[0] != 1){
+		std::cout << "FAILED: daily climatology has " << daily.keys().size() << " groups\n";
+		++nfail;
+	}
+	for (long key : {101L, 228L, 229L, 301L, 311L, 312L, 1231L}) nfail += check("daily", key, daily, e_day[key]);
+	in_file.close();
+
+	// ~~ monthly means on model calendars: steps are grouped by the dates in the calendar of the time axis
+	for (std::string calendar : {"360_day", "noleap"}){
+		write_file(path, nt, calendar);
+		in_file.open(path, netCDF::NcFile::read);
+		in_file.readMeta();
+		flare::GeoCube<float> c;
+		c.readMeta(in_file, "x");
+
+		auto e = expected(nt, flare::Period::month, calendar);
+		flare::TemporalReducer<float> r(flare::Period::month);
+		r.accumulate(c, 0, nt, 7);
+		std::vector<long> ekeys;
+		for (auto& g : e) ekeys.push_back(g.first);
+		if (r.keys() != ekeys){
+			std::cout << "FAILED: " << r.keys().size() << " monthly groups on the " << calendar << " calendar, expected " << ekeys.size() << "\n";
+			++nfail;
+		}
+		for (long key : ekeys) nfail += check("monthly (" + calendar + ")", key, r, e[key]);
+		in_file.close();
+	}
+
+	std::remove(path.c_str());
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+	return 0;
+}
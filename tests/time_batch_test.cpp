@@ -0,0 +1,76 @@
+#include <iostream>
+#include <random>
+#include <cmath>
+#include "../include/time_math.h"
+
+// Check the batch date <--> julian conversions against the scalar functions, and the fast
+// ISO-8601 parser against string_to_date
+int main(){
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> uj(2378497, 2524594); // 1800 - 2200
+	std::vector<double> js(100000);
+	for (auto& j : js) j = uj(rng);
+	for (int k=0; k<400*12; ++k) js.push_back(flare::date_to_julian(flare::string_to_date(std::to_string(1800 + k/12) + "-" + std::to_string(k%12+1) + "-01 00:00:00"))); // month boundaries
+
+	flare::DateColumns c = flare::julian_to_dates(js);
+	for (size_t i=0; i<js.size(); ++i){
+		std::tm t = flare::julian_to_date(js[i]);
+		double s_batch = c.hour[i]*3600 + c.minute[i]*60 + c.second[i];
+		double s_scalar = t.tm_hour*3600 + t.tm_min*60 + t.tm_sec;
+		if (c.year[i] != t.tm_year+1900 || c.month[i] != t.tm_mon+1 || c.day[i] != t.tm_mday || std::fabs(s_batch - s_scalar) > 1){
+			std::cout << "FAILED: julian_to_ymdhms(" << std::setprecision(12) << js[i] << ") = "
+			          << c.year[i] << "-" << c.month[i] << "-" << c.day[i] << " " << c.hour[i] << ":" << c.minute[i] << ":" << c.second[i]
+			          << ", expected " << flare::date_to_string(t) << "\n";
+			return 1;
+		}
+	}
+
+	std::vector<double> back = flare::dates_to_julian(c);
+	for (size_t i=0; i<js.size(); ++i){
+		if (std::fabs(back[i] - js[i]) > 1e-8){
+			std::cout << "FAILED: round trip of " << std::setprecision(12) << js[i] << " gives " << back[i] << "\n";
+			return 1;
+		}
+	}
+
+	// parser
+	std::vector<std::string> same = {"2013-01-01 00:30:00", "2001-12-18 12:10:45", "0000-03-01 00:00:00", "1990-06-17", "1850-1-1 0:0:0"};
+	for (auto& s : same){
+		double j_ref = flare::date_to_julian(flare::string_to_date(s));
+		if (std::fabs(flare::iso8601_to_julian(s) - j_ref) > 1e-8){
+			std::cout << "FAILED: iso8601_to_julian(" << s << ") = " << std::setprecision(12) << flare::iso8601_to_julian(s) << ", expected " << j_ref << "\n";
+			return 1;
+		}
+	}
+
+	double j0 = flare::iso8601_to_julian("2013-01-01 00:30:00");
+	std::vector<std::pair<std::string, double>> variants = {
+		{"2013-01-01T00:30:00Z", 0},
+		{"2013-01-01T00:30:00.5Z", 0.5/86400},
+		{"2013-01-01 00:30", 0},
+		{"2013-01-01T02:30:00+02:00", 0},
+		{"2012-12-31T23:30:00-01", 0},
+		{"2013-01-01 00:30:00 UTC", 0},
+	};
+	for (auto& v : variants){
+		if (std::fabs(flare::iso8601_to_julian(v.first) - (j0 + v.second)) > 1e-8){
+			std::cout << "FAILED: iso8601_to_julian(" << v.first << ")\n";
+			return 1;
+		}
+	}
+
+	int y, m, d, h, mi;
+	double sec;
+	for (std::string bad : {"", "2013", "2013-13-01", "2013-01-01x", "2013-01-01 10"}){
+		if (flare::parse_iso8601(bad, y, m, d, h, mi, sec)){
+			std::cout << "FAILED: '" << bad << "' was parsed\n";
+			return 1;
+		}
+	}
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "flare.h"
+
+// Check interpolated reads against slices read directly: at slice times the data must be
+// identical to the slice, and half way between two slices it must be their average
+int main(){
+
+	flare::NcFilePP in_file;
+	in_file.open("tests/data/gpp.2000-2015.nc", netCDF::NcFile::read);
+	in_file.readMeta();
+
+	flare::GeoCube<float> v;
+	v.readMeta(in_file);
+	v.setCoordBounds(v.lon_idx, 70, 80);
+	v.setCoordBounds(v.lat_idx, 15, 25);
+
+	flare::GeoCube<float> v_ref;
+	v_ref.readMeta(in_file);
+	v_ref.setCoordBounds(v_ref.lon_idx, 70, 80);
+	v_ref.setCoordBounds(v_ref.lat_idx, 15, 25);
+
+	flare::TimeInterpolator<float> interp(v, false, true);
+
+	std::vector<float> a(v_ref.sliceSize()), b(v_ref.sliceSize());
+	for (size_t k=0; k<20; ++k){
+		v_ref.readSliceInto(k, a.data());
+		v_ref.readSliceInto(k+1, b.data());
+
+		double t0 = v.t_index_to_julian(k), t1 = v.t_index_to_julian(k+1);
+
+		double f = interp.read(t0);
+		for (size_t i=0; i<a.size(); ++i){
+			if (f != 0 || (v.vec[i] != a[i] && !(std::isnan(v.vec[i]) && std::isnan(a[i])))){
+				std::cout << "FAILED: mismatch at slice time " << k << "\n";
+				return 1;
+			}
+		}
+
+		f = interp.read((t0+t1)/2);
+		for (size_t i=0; i<a.size(); ++i){
+			bool missing = (a[i] == v.missing_value || b[i] == v.missing_value || std::isnan(a[i]) || std::isnan(b[i]));
+			if (std::fabs(f - 0.5) > 1e-9 || (!missing && std::fabs(v.vec[i] - (a[i]+b[i])/2) > 1e-5*std::fabs(a[i]+b[i]))){
+				std::cout << "FAILED: mismatch between slices " << k << " and " << k+1 << "\n";
+				return 1;
+			}
+		}
+	}
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+
+	return 0;
+}
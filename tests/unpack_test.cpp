@@ -0,0 +1,60 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include "../include/unpack.h"
+
+// scalar reference: out = (in == fill)? NaN : in*scale + offset, fused if the target has FMA
+template <class P>
+static std::vector<float> reference(const std::vector<P>& in, float scale, float offset, P fill){
+	std::vector<float> out(in.size());
+	for (size_t i=0; i<in.size(); ++i){
+#ifdef __FMA__
+		float v = std::fma(float(in[i]), scale, offset);
+#else
+		volatile float prod = float(in[i])*scale;
+		float v = prod + offset;
+#endif
+		out[i] = (in[i] == fill)? std::nanf("") : v;
+	}
+	return out;
+}
+
+template <class P>
+static int check(const char* type, const std::vector<P>& in, float scale, float offset, P fill){
+	std::vector<float> out(in.size()), ref = reference(in, scale, offset, fill);
+	flare::unpack<P, float>(in.data(), out.data(), in.size(), scale, offset, fill, true);
+	for (size_t i=0; i<in.size(); ++i){
+		bool same = (std::isnan(out[i]) && std::isnan(ref[i])) || std::memcmp(&out[i], &ref[i], sizeof(float)) == 0;
+		if (!same){
+			std::cout << "FAILED: unpack<" << type << "> at " << i << ": " << out[i] << " != " << ref[i] << "\n";
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// The vectorized kernels (if the build targets AVX2/AVX-512) must give bitwise the same values as
+// a scalar loop with the same rounding, in the vector body and in the remainder, and replace fill values
+int main(){
+	size_t n = 1003;
+	float scale = 0.0137f, offset = 271.3f;
+	std::vector<int16_t> i16(n);
+	std::vector<int8_t> i8(n);
+	std::vector<float> f32(n);
+	for (size_t i=0; i<n; ++i){
+		i16[i] = int16_t((i*7919) % 65536 - 32768);
+		i8[i] = int8_t((i*31) % 256 - 128);
+		f32[i] = float(i16[i])*0.37f;
+	}
+	i16[5] = i16[900] = -32767;
+	i8[17] = -127;
+	f32[3] = 1e20f;
+
+	int nfail = check<int16_t>("int16", i16, scale, offset, -32767) + check<int8_t>("int8", i8, scale, offset, -127) + check<float>("float", f32, scale, offset, 1e20f);
+	if (nfail > 0) return 1;
+
+	std::cout << "-----------------\n";
+	std::cout << "All tests PASSED!\n";
+	return 0;
+}